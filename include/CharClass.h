@@ -0,0 +1,36 @@
+#pragma once
+
+#ifndef CHAR_CLASS_H
+#define CHAR_CLASS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Whitespace is classified with SSE2 or AVX2 when the compiler targets them,
+// setting this to 0 forces the scalar loops.
+#ifndef CHAR_CLASS_SIMD
+#define CHAR_CLASS_SIMD 1
+#endif
+
+// Leading spaces and tabs of a range, tabs are counted apart since they
+// advance further than a space
+struct BlankRun
+{
+	std::size_t length;
+	std::size_t tabs;
+};
+
+// Character classification shared by the loaders and the geometry builder,
+// blank runs are skipped a lane at a time instead of per character: 16 bytes
+// with SSE2, 32 with AVX2 and 8 on the scalar fallback.
+class CharClass
+{
+public:
+	static BlankRun blankRun(const char* data, std::size_t size);
+
+	static BlankRun blankRun(const std::uint32_t* data, std::size_t size);
+
+	static std::size_t skipWhitespace(const char* data, std::size_t size);
+};
+
+#endif
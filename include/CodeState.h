@@ -5,8 +5,37 @@
 
 #include <string>
 
+// Stages are timed and their counters recorded unless this is set to 0,
+// without it pushing and popping only prints the stage names.
+#ifndef CODE_STATE_PROFILING
+#define CODE_STATE_PROFILING 1
+#endif
+
 void pushCodeState(std::string_view state);
 
 void popCodeState();
 
-#endif
\ No newline at end of file
+#if CODE_STATE_PROFILING
+void countCodeState(std::string_view counter, std::size_t value);
+
+// Finished stages are only kept for saveCodeProfile once this was called,
+// stages popped before are left out
+void enableCodeProfile();
+
+bool saveCodeProfile(const std::string& filePath);
+#else
+inline void countCodeState(std::string_view, std::size_t)
+{
+}
+
+inline void enableCodeProfile()
+{
+}
+
+inline bool saveCodeProfile(const std::string&)
+{
+	return false;
+}
+#endif
+
+#endif
@@ -0,0 +1,30 @@
+#pragma once
+
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Raw deflate (RFC 1951) encoder. A range is compressed on its own but may
+// refer back into the bytes before it, so ranges compressed on different
+// threads are concatenated into one stream.
+class Deflate
+{
+public:
+	static constexpr int MaximumLevel = 9;
+	static constexpr std::size_t WindowSize = 32768;
+
+	// Appends data[begin, end) as whole blocks, level 0 only stores. Unless
+	// this is the last range the output ends on an empty stored block, so
+	// the next range starts on a byte boundary.
+	static void compress(const std::uint8_t* data, std::size_t begin, std::size_t end, int level, bool last, std::vector<std::uint8_t>& output);
+
+	static std::uint32_t adler32(const std::uint8_t* data, std::size_t size, std::uint32_t adler = 1);
+
+	// Adler-32 of two ranges joined, the second one being length bytes long
+	static std::uint32_t combineAdler32(std::uint32_t first, std::uint32_t second, std::size_t length);
+};
+
+#endif
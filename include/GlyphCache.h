@@ -0,0 +1,118 @@
+#pragma once
+
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Glyph.hpp>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <mutex>
+#include <unordered_map>
+
+// Glyphs and metrics of one (font, characterSize, bold, outline) combination.
+// Printable ASCII goes into flat tables, filled from the font on first use
+// so sizes that are only measured never load every glyph. Anything else is
+// fetched from the font once and kept in an overflow map.
+class GlyphTable
+{
+public:
+	static constexpr sf::Uint32 FirstCharacter = 32;
+	static constexpr sf::Uint32 LastCharacter  = 127;
+	static constexpr sf::Uint32 CharacterCount = LastCharacter - FirstCharacter;
+private:
+	const sf::Font* m_font;
+	sf::Uint32 m_characterSize;
+	bool m_bold;
+	float m_outlineThickness;
+	float m_lineSpacing;
+	float m_underlinePosition;
+	float m_underlineThickness;
+	float m_spaceAdvance;
+	sf::FloatRect m_xBounds;
+	mutable std::array<sf::Glyph, CharacterCount> m_glyphs;
+	mutable std::array<std::atomic<bool>, CharacterCount> m_loaded;
+	mutable std::array<std::atomic<float>, CharacterCount * CharacterCount> m_kernings; // NaN until looked up
+	mutable std::mutex m_mutex;
+	mutable std::unordered_map<sf::Uint32, sf::Glyph> m_overflow;
+	mutable std::atomic<std::size_t> m_glyphCount;
+public:
+	GlyphTable(const sf::Font& font, sf::Uint32 characterSize, bool bold, float outlineThickness);
+
+	const sf::Glyph& getGlyph(sf::Uint32 codepoint) const;
+
+	float getKerning(sf::Uint32 first, sf::Uint32 second) const;
+
+	float getLineSpacing() const;
+
+	float getUnderlinePosition() const;
+
+	float getUnderlineThickness() const;
+
+	float getSpaceAdvance() const;
+
+	sf::FloatRect getXBounds() const;
+
+	// Glyphs this table loaded into the font texture so far
+	std::size_t getGlyphCount() const;
+
+private:
+	static bool isFlat(sf::Uint32 codepoint);
+
+	void loadGlyph(std::size_t index) const;
+};
+
+// Process wide cache of glyph tables, every table is built once per run and
+// shared by every line and file using the same font settings.
+class GlyphCache
+{
+public:
+	static const GlyphTable& get(const sf::Font& font, sf::Uint32 characterSize, bool bold, float outlineThickness = 0.f);
+
+	static void clear();
+
+	// Glyphs loaded into the texture of one character size by every table,
+	// a texture read back earlier is stale once this changes
+	static std::size_t getGlyphCount(const sf::Font& font, sf::Uint32 characterSize);
+};
+
+inline bool GlyphTable::isFlat(sf::Uint32 codepoint)
+{
+	return codepoint >= FirstCharacter && codepoint < LastCharacter;
+}
+
+inline const sf::Glyph& GlyphTable::getGlyph(sf::Uint32 codepoint) const
+{
+	if (isFlat(codepoint)) {
+		const std::size_t index = codepoint - FirstCharacter;
+		if (!m_loaded[index].load(std::memory_order_acquire)) {
+			loadGlyph(index);
+		}
+		return m_glyphs[index];
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto glyph = m_overflow.find(codepoint);
+	if (glyph == m_overflow.end()) {
+		glyph = m_overflow.emplace(codepoint, m_font->getGlyph(codepoint, m_characterSize, m_bold, m_outlineThickness)).first;
+		++m_glyphCount;
+	}
+	return glyph->second;
+}
+
+inline float GlyphTable::getKerning(sf::Uint32 first, sf::Uint32 second) const
+{
+	if (isFlat(first) && isFlat(second)) {
+		auto& entry = m_kernings[(first - FirstCharacter) * CharacterCount + (second - FirstCharacter)];
+		float kerning = entry.load(std::memory_order_relaxed);
+		if (std::isnan(kerning)) {
+			kerning = m_font->getKerning(first, second, m_characterSize);
+			entry.store(kerning, std::memory_order_relaxed);
+		}
+		return kerning;
+	}
+	return m_font->getKerning(first, second, m_characterSize);
+}
+
+#endif
@@ -4,7 +4,14 @@
 #define HIGHLIGHTER_H
 
 #include "SmartText.h"
-#include <unordered_map>
+#include "KeywordMatcher.h"
+#include "Lexer.h"
+#include "KeywordTables.h"
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
 
 struct Detail
 {
@@ -50,14 +57,35 @@ struct Detail
 	}
 };
 
+// Run of characters sharing one color and style, the spans of a line are
+// ordered and cover it without gaps.
+struct HighlightSpan
+{
+	std::size_t start;
+	std::size_t length;
+	sf::Color color;
+	sf::Text::Style style;
+};
+
 class Highlighter
 {
 private:
 	const sf::Font* m_font;
 	sf::Uint32 m_characterSize;
-	std::unordered_map<std::string, Detail> m_keywords;
+	// Runtime additions on top of the built in tables, an empty detail removes
+	// a built in keyword. Ordered so it can be searched with a string view.
+	std::map<std::string, std::optional<Detail>, std::less<>> m_overrides;
+	mutable bool m_needsUpdate;
+	mutable KeywordMatcher m_matcher;
+	mutable std::vector<Detail> m_matcherDetails;
+	mutable std::pmr::vector<Lexer::Token> m_tokens;
+	mutable std::pmr::vector<const Detail*> m_marks;
 public:
-	Highlighter();
+	// The scratch buffers reused by every line are allocated from resource
+	explicit Highlighter(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	// Same keywords as highlighter, with its own scratch buffers
+	Highlighter(const Highlighter& highlighter, std::pmr::memory_resource* resource);
 
 	void setFont(const sf::Font& font);
 
@@ -65,22 +93,26 @@ public:
 
 	const sf::Font& getFont() const;
 
+	bool loadKeywords(const std::string& filePath, KeywordGroup group);
+
 	void addKeyword(const std::string& key, Detail detail);
 
 	bool removeKeyword(const std::string& key);
 
 	Detail getKeyword(const std::string& key) const;
 
-	SmartText buildText(const std::string& line) const;
+	const Detail* findKeyword(std::string_view key) const;
 
-private:
-	void highlightComments(SmartText& text) const;
+	static Detail getGroupDetail(KeywordGroup group);
 
-	void highlightKeywords(SmartText& text) const;
+	void highlight(std::string_view line, std::vector<HighlightSpan>& spans) const;
 
-	void highlightMacros(SmartText& text) const;
+	static void appendSpans(const std::vector<HighlightSpan>& spans, std::size_t offset, std::pmr::vector<SmartText::Span>& chunks);
 
-	void highlightQuotes(SmartText& text) const;
+	SmartText buildText(const std::string& line) const;
+
+private:
+	void ensureMatcherUpdate() const;
 };
 
 #endif
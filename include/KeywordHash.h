@@ -0,0 +1,71 @@
+#pragma once
+
+#ifndef KEYWORD_HASH_H
+#define KEYWORD_HASH_H
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "KeywordTables.h"
+
+// Minimal perfect hash over a keyword table, every key owns exactly one slot
+// so a lookup hashes the identifier once and compares a single entry. Lengths
+// and first characters no key has are rejected before hashing at all.
+class KeywordHash
+{
+private:
+	std::vector<std::uint32_t> m_seeds; // Per bucket, moves the keys of a bucket onto free slots
+	std::vector<const BuiltinKeyword*> m_slots;
+	std::uint64_t m_lengths; // Bit n is set when a key is n characters long
+	std::array<std::uint64_t, 4> m_firstCharacters;
+public:
+	KeywordHash(const BuiltinKeyword* entries, std::size_t count);
+
+	// Built once from KeywordTables::entries on first use
+	static const KeywordHash& getBuiltin();
+
+	const BuiltinKeyword* find(std::string_view key) const;
+
+private:
+	static std::uint32_t hash(std::string_view key);
+
+	static std::uint32_t place(std::uint32_t hash, std::uint32_t seed);
+};
+
+inline std::uint32_t KeywordHash::hash(std::string_view key)
+{
+	// FNV-1a
+	std::uint32_t value = 2166136261u;
+	for (char ch : key) {
+		value = (value ^ static_cast<unsigned char>(ch)) * 16777619u;
+	}
+	return value;
+}
+
+inline std::uint32_t KeywordHash::place(std::uint32_t hash, std::uint32_t seed)
+{
+	std::uint32_t value = hash ^ (seed * 0x9E3779B9u);
+	value ^= value >> 16;
+	value *= 0x85EBCA6Bu;
+	value ^= value >> 13;
+	return value;
+}
+
+inline const BuiltinKeyword* KeywordHash::find(std::string_view key) const
+{
+	const std::size_t length = key.size();
+	if (length == 0 || length >= 64 || !(m_lengths >> length & 1u)) {
+		return nullptr;
+	}
+	const unsigned char first = static_cast<unsigned char>(key[0]);
+	if (!(m_firstCharacters[first >> 6] >> (first & 63u) & 1u)) {
+		return nullptr;
+	}
+
+	const std::uint32_t value = hash(key);
+	const BuiltinKeyword* entry = m_slots[place(value, m_seeds[value % m_seeds.size()]) % m_slots.size()];
+	return entry->key == key ? entry : nullptr;
+}
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#ifndef KEYWORD_MATCHER_H
+#define KEYWORD_MATCHER_H
+
+#include <array>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Multi-pattern matcher (Aho-Corasick) used to find every operator of a
+// token in a single left-to-right scan, overlapping matches are reported.
+class KeywordMatcher
+{
+public:
+	struct Match {
+		std::size_t index;
+		std::size_t length;
+		std::size_t pattern;
+	};
+private:
+	using State = std::int32_t;
+
+	struct Node {
+		State failure;
+		State output;
+		std::int32_t pattern;
+	};
+
+	std::vector<std::string> m_patterns;
+	std::vector<Node> m_nodes;
+	std::vector<State> m_transitions;
+	std::array<std::uint8_t, 256> m_classes;
+	std::size_t m_classCount;
+public:
+	KeywordMatcher();
+
+	void clear();
+
+	std::size_t addPattern(std::string_view pattern);
+
+	void compile();
+
+	template<typename Callback>
+	void scan(std::string_view text, Callback&& callback) const;
+
+private:
+	State next(State state, unsigned char ch) const;
+};
+
+template<typename Callback>
+void KeywordMatcher::scan(std::string_view text, Callback&& callback) const
+{
+	if (m_nodes.empty()) {
+		return;
+	}
+
+	State state = 0;
+	const std::size_t size = text.size();
+	for (std::size_t index = 0; index != size; ++index) {
+		state = next(state, static_cast<unsigned char>(text[index]));
+
+		for (State found = m_nodes[state].pattern >= 0 ? state : m_nodes[state].output; found > 0; found = m_nodes[found].output) {
+			const std::size_t pattern = static_cast<std::size_t>(m_nodes[found].pattern);
+			const std::size_t length = m_patterns[pattern].size();
+			callback(Match{ index + 1 - length, length, pattern });
+		}
+	}
+}
+
+inline KeywordMatcher::State KeywordMatcher::next(State state, unsigned char ch) const
+{
+	return m_transitions[static_cast<std::size_t>(state) * m_classCount + m_classes[ch]];
+}
+
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+
+#ifndef KEYWORD_TABLES_H
+#define KEYWORD_TABLES_H
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+enum class KeywordGroup {
+	Keyword,
+	StdType,
+	Operator
+};
+
+struct BuiltinKeyword
+{
+	std::string_view key;
+	KeywordGroup group;
+};
+
+// Default C++ tables compiled into the binary, the same words as the files in
+// include/highlighting, available without file I/O at startup. Lookups go
+// through KeywordHash, the table is kept sorted to rule out duplicates.
+namespace KeywordTables
+{
+	inline constexpr BuiltinKeyword entries[] = {
+		{ "%", KeywordGroup::Operator },
+		{ "%=", KeywordGroup::Operator },
+		{ "*", KeywordGroup::Operator },
+		{ "*=", KeywordGroup::Operator },
+		{ "+", KeywordGroup::Operator },
+		{ "++", KeywordGroup::Operator },
+		{ "+=", KeywordGroup::Operator },
+		{ "-", KeywordGroup::Operator },
+		{ "--", KeywordGroup::Operator },
+		{ "-=", KeywordGroup::Operator },
+		{ "/", KeywordGroup::Operator },
+		{ "/=", KeywordGroup::Operator },
+		{ "<<", KeywordGroup::Operator },
+		{ "<<=", KeywordGroup::Operator },
+		{ ">>", KeywordGroup::Operator },
+		{ ">>=", KeywordGroup::Operator },
+		{ "array", KeywordGroup::StdType },
+		{ "asm", KeywordGroup::Keyword },
+		{ "auto", KeywordGroup::Keyword },
+		{ "bool", KeywordGroup::Keyword },
+		{ "break", KeywordGroup::Keyword },
+		{ "case", KeywordGroup::Keyword },
+		{ "catch", KeywordGroup::Keyword },
+		{ "char", KeywordGroup::Keyword },
+		{ "class", KeywordGroup::Keyword },
+		{ "const", KeywordGroup::Keyword },
+		{ "const_cast", KeywordGroup::Keyword },
+		{ "continue", KeywordGroup::Keyword },
+		{ "default", KeywordGroup::Keyword },
+		{ "delete", KeywordGroup::Keyword },
+		{ "deque", KeywordGroup::StdType },
+		{ "do", KeywordGroup::Keyword },
+		{ "double", KeywordGroup::Keyword },
+		{ "dynamic_cast", KeywordGroup::Keyword },
+		{ "else", KeywordGroup::Keyword },
+		{ "enum", KeywordGroup::Keyword },
+		{ "explicit", KeywordGroup::Keyword },
+		{ "export", KeywordGroup::Keyword },
+		{ "extern", KeywordGroup::Keyword },
+		{ "false", KeywordGroup::Keyword },
+		{ "false_type", KeywordGroup::StdType },
+		{ "float", KeywordGroup::Keyword },
+		{ "for", KeywordGroup::Keyword },
+		{ "forward_list", KeywordGroup::StdType },
+		{ "friend", KeywordGroup::Keyword },
+		{ "fstream", KeywordGroup::StdType },
+		{ "goto", KeywordGroup::Keyword },
+		{ "if", KeywordGroup::Keyword },
+		{ "ifstream", KeywordGroup::StdType },
+		{ "inline", KeywordGroup::Keyword },
+		{ "int", KeywordGroup::Keyword },
+		{ "iostream", KeywordGroup::StdType },
+		{ "istream", KeywordGroup::StdType },
+		{ "istringstream", KeywordGroup::StdType },
+		{ "list", KeywordGroup::StdType },
+		{ "long", KeywordGroup::Keyword },
+		{ "map", KeywordGroup::StdType },
+		{ "mutable", KeywordGroup::Keyword },
+		{ "namespace", KeywordGroup::Keyword },
+		{ "new", KeywordGroup::Keyword },
+		{ "ofstream", KeywordGroup::StdType },
+		{ "operator", KeywordGroup::Keyword },
+		{ "ostream", KeywordGroup::StdType },
+		{ "ostringstream", KeywordGroup::StdType },
+		{ "private", KeywordGroup::Keyword },
+		{ "protected", KeywordGroup::Keyword },
+		{ "public", KeywordGroup::Keyword },
+		{ "register", KeywordGroup::Keyword },
+		{ "reinterpret_cast", KeywordGroup::Keyword },
+		{ "return", KeywordGroup::Keyword },
+		{ "set", KeywordGroup::StdType },
+		{ "short", KeywordGroup::Keyword },
+		{ "signed", KeywordGroup::Keyword },
+		{ "sizeof", KeywordGroup::Keyword },
+		{ "stack", KeywordGroup::StdType },
+		{ "static", KeywordGroup::Keyword },
+		{ "static_cast", KeywordGroup::Keyword },
+		{ "string", KeywordGroup::StdType },
+		{ "stringbuf", KeywordGroup::StdType },
+		{ "stringstream", KeywordGroup::StdType },
+		{ "struct", KeywordGroup::Keyword },
+		{ "switch", KeywordGroup::Keyword },
+		{ "template", KeywordGroup::Keyword },
+		{ "this", KeywordGroup::Keyword },
+		{ "throw", KeywordGroup::Keyword },
+		{ "true", KeywordGroup::Keyword },
+		{ "true_type", KeywordGroup::StdType },
+		{ "try", KeywordGroup::Keyword },
+		{ "typedef", KeywordGroup::Keyword },
+		{ "typeid", KeywordGroup::Keyword },
+		{ "typename", KeywordGroup::Keyword },
+		{ "union", KeywordGroup::Keyword },
+		{ "unordered_map", KeywordGroup::StdType },
+		{ "unordered_set", KeywordGroup::StdType },
+		{ "unsigned", KeywordGroup::Keyword },
+		{ "using", KeywordGroup::Keyword },
+		{ "vector", KeywordGroup::StdType },
+		{ "virtual", KeywordGroup::Keyword },
+		{ "void", KeywordGroup::Keyword },
+		{ "volatile", KeywordGroup::Keyword },
+		{ "wchar_t", KeywordGroup::Keyword },
+		{ "while", KeywordGroup::Keyword },
+		{ "wstring", KeywordGroup::StdType },
+	};
+
+	constexpr bool isSorted()
+	{
+		for (std::size_t index = 1; index != std::size(entries); ++index) {
+			if (!(entries[index - 1].key < entries[index].key)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static_assert(isSorted(), "keyword table has to be sorted and free of duplicates");
+}
+
+#endif
@@ -0,0 +1,42 @@
+#pragma once
+
+#ifndef LEXER_H
+#define LEXER_H
+
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+// Splits a single line of C++ into tokens in one left-to-right pass. Lines
+// are scrambled independently so no state is carried between lines, block
+// comments and literals that are not closed run to the end of the line.
+class Lexer
+{
+public:
+	enum class Kind {
+		Whitespace,
+		Identifier,
+		Number,
+		Operator,
+		Punctuation,
+		String,
+		Character,
+		Comment,
+		Preprocessor,
+		IncludePath
+	};
+
+	struct Token {
+		Kind kind;
+		std::size_t start;
+		std::size_t length;
+	};
+
+	static void tokenize(std::string_view line, std::pmr::vector<Token>& tokens);
+
+	static bool isIdentifier(char ch);
+
+	static bool isOperator(char ch);
+};
+
+#endif
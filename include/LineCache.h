@@ -0,0 +1,54 @@
+#pragma once
+
+#ifndef LINE_CACHE_H
+#define LINE_CACHE_H
+
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Highlighter.h"
+
+// Content addressed cache of highlighted lines. Identical lines, whether in
+// the same file, another variant or another file, are lexed once. The spans
+// do not depend on the font, the glyph geometry of a line is kept for every
+// font and character size it was drawn at.
+class LineCache
+{
+public:
+	using Spans = std::vector<HighlightSpan>;
+	// Glyph quads of a line drawn at the origin, the baseline sits one
+	// character size below it
+	using Vertices = std::vector<sf::Vertex>;
+private:
+	using GeometryKey = std::pair<const sf::Font*, unsigned>;
+
+	// Keys view the line owned by their entry, lines are looked up as views
+	// into the source without building a string
+	struct Entry {
+		std::string line;
+		Spans spans;
+		std::map<GeometryKey, Vertices> geometry;
+	};
+
+	mutable std::mutex m_mutex;
+	std::unordered_map<std::string_view, std::unique_ptr<Entry>> m_lines;
+public:
+	const Spans* find(std::string_view line) const;
+
+	const Spans& insert(std::string_view line, Spans spans);
+
+	const Vertices* findGeometry(std::string_view line, const sf::Font& font, unsigned characterSize) const;
+
+	// The line has to be inserted already
+	const Vertices& insertGeometry(std::string_view line, const sf::Font& font, unsigned characterSize, Vertices vertices);
+
+	void clear();
+};
+
+#endif
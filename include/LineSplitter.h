@@ -0,0 +1,38 @@
+#pragma once
+
+#ifndef LINE_SPLITTER_H
+#define LINE_SPLITTER_H
+
+#include <string_view>
+
+// Splits source text into the lines that get scrambled. A trailing '\r' and
+// the "~>" and "<~" markers are stripped, lines of only whitespace are
+// dropped and the indentation is stripped when asked for. Both scramblers
+// read their lines through this so the rules are kept in one place.
+class LineSplitter
+{
+public:
+	struct Line
+	{
+		std::string_view text; // View into the data
+		bool kept;             // False for lines of only whitespace
+		std::size_t fixedStart; // Kept lines [fixedStart, fixedEnd) stay in place,
+		std::size_t fixedEnd;   // the range is empty unless a "<~" ends here
+	};
+private:
+	std::string_view m_data;
+	std::size_t m_position;
+	std::size_t m_lineNumber;
+	std::size_t m_markStart;
+	bool m_stripIndent;
+public:
+	LineSplitter(std::string_view data, bool stripIndent);
+
+	// Reads the next line, false once the data is exhausted
+	bool next(Line& line);
+
+	// Number of kept lines read so far
+	std::size_t getLineCount() const;
+};
+
+#endif
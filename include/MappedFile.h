@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <string_view>
+
+// Read only view of a whole file mapped into memory, pages are only loaded
+// by the operating system once they are touched.
+class MappedFile
+{
+private:
+	const char* m_data;
+	std::size_t m_size;
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_descriptor;
+#endif
+public:
+	MappedFile();
+	explicit MappedFile(const std::string& filePath);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& file) noexcept;
+	MappedFile& operator=(MappedFile&& file) noexcept;
+
+	bool open(const std::string& filePath);
+
+	void close();
+
+	bool isOpen() const;
+
+	const char* getData() const;
+
+	std::size_t getSize() const;
+
+	std::string_view getView() const;
+
+private:
+	void swap(MappedFile& file) noexcept;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#pragma once
+
+#ifndef PAGE_ARENA_H
+#define PAGE_ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+
+// Monotonic memory for the temporaries of one page: the page text, its chunks
+// and vertices, and the highlighter scratch buffers. Nothing is freed on its
+// own, everything is released in one shot once the page is saved. The buffer
+// keeps the size the last page needed, so later pages and variants of the same
+// file are served without touching the heap, and shrinks again after a spike.
+class PageArena : public std::pmr::memory_resource
+{
+private:
+	// Heap memory requested once the buffer runs out
+	class Upstream : public std::pmr::memory_resource
+	{
+	public:
+		std::size_t allocations = 0;
+		std::size_t bytes = 0;
+	private:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+		void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+	};
+
+	std::unique_ptr<std::byte[]> m_buffer;
+	std::size_t m_capacity;
+	std::size_t m_allocations;
+	std::size_t m_bytes;
+	Upstream m_upstream;
+	std::optional<std::pmr::monotonic_buffer_resource> m_resource;
+public:
+	explicit PageArena(std::size_t capacity = 0);
+
+	PageArena(const PageArena&) = delete;
+
+	PageArena& operator=(const PageArena&) = delete;
+
+	void release();
+
+	std::size_t getAllocationCount() const;
+
+	std::size_t getHeapAllocationCount() const;
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+
+	void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override;
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#ifndef PAGE_GEOMETRY_H
+#define PAGE_GEOMETRY_H
+
+#include <SFML/Graphics.hpp>
+#include <memory_resource>
+#include <vector>
+#include "SmartText.h"
+
+// Every glyph quad and border rectangle of a page in one contiguous vertex
+// array, drawn with a single call. All texts of a page share one font and
+// character size, borders sample the white square SFML reserves at the
+// top-left of every font texture.
+class PageGeometry : public sf::Drawable
+{
+private:
+	const sf::Font* m_font;
+	sf::Uint32 m_characterSize;
+	std::pmr::vector<sf::Vertex> m_vertices;
+public:
+	explicit PageGeometry(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	void clear();
+
+	void setFont(const sf::Font& font, sf::Uint32 characterSize);
+
+	void reserve(std::size_t vertices);
+
+	void addText(const SmartText& text);
+
+	void addVertices(const std::vector<sf::Vertex>& vertices, sf::Vector2f offset);
+
+	void addRectangle(sf::FloatRect rect, sf::Color color);
+
+	const sf::Font* getFont() const;
+
+	sf::Uint32 getCharacterSize() const;
+
+	const std::pmr::vector<sf::Vertex>& getVertices() const;
+
+private:
+	virtual void draw(sf::RenderTarget& target, sf::RenderStates states) const override;
+};
+
+#endif
@@ -0,0 +1,86 @@
+#pragma once
+
+#ifndef PAGE_LAYOUT_H
+#define PAGE_LAYOUT_H
+
+#include <SFML/Graphics/Font.hpp>
+#include <algorithm>
+#include <string_view>
+#include <vector>
+#include "Highlighter.h"
+#include "GlyphCache.h"
+
+// Picks the character size of a file and splits it into pages. Advances and
+// line spacing grow linearly with the character size, so the largest size
+// that fits the page width and height is solved from one measurement at a
+// reference size, then corrected against the real metrics of that size.
+class PageLayout
+{
+public:
+	static constexpr unsigned ReferenceSize = 64;
+	// Glyph tables are built for every probed size, larger glyphs would not
+	// fit on a single font texture
+	static constexpr unsigned MaximumSize = 512;
+private:
+	const sf::Font* m_font;
+	unsigned m_width;
+	unsigned m_height;
+	float m_borderHeight;
+	std::size_t m_lineCount;
+	std::string_view m_widestLine;
+	const std::vector<HighlightSpan>* m_widestSpans;
+	float m_widestWidth; // At the reference size
+	unsigned m_characterSize;
+	float m_spacing;
+	std::size_t m_linesPerPage;
+	std::size_t m_pageCount;
+public:
+	PageLayout(const sf::Font& font, unsigned width, unsigned height, float borderHeight);
+
+	void addLine(std::string_view line, const std::vector<HighlightSpan>& spans);
+
+	// Uses the largest size that fits every line on one page, unless that is
+	// smaller than minimumSize. Then the lines are spread evenly over as few
+	// pages as minimumSize allows.
+	void solve(unsigned minimumSize);
+
+	unsigned getCharacterSize() const;
+
+	float getSpacing() const;
+
+	std::size_t getLinesPerPage() const;
+
+	std::size_t getPageCount() const;
+
+	// Pen advance of a line, bold spans are measured with bold glyphs
+	static float measure(std::string_view line, const std::vector<HighlightSpan>& spans, const sf::Font& font, unsigned characterSize);
+
+private:
+	float getSlotHeight(unsigned characterSize) const;
+
+	bool fitsWidth(unsigned characterSize) const;
+
+	bool fitsHeight(unsigned characterSize, std::size_t lines) const;
+
+	unsigned getWidthLimit() const;
+
+	unsigned getHeightLimit(std::size_t lines, unsigned widthLimit) const;
+
+	template<typename Fits>
+	static unsigned correct(float estimate, unsigned limit, Fits fits);
+};
+
+template<typename Fits>
+unsigned PageLayout::correct(float estimate, unsigned limit, Fits fits)
+{
+	unsigned size = static_cast<unsigned>(std::clamp(estimate, 1.f, static_cast<float>(limit)));
+	while (size < limit && fits(size + 1)) {
+		++size;
+	}
+	while (size > 1 && !fits(size)) {
+		--size;
+	}
+	return size;
+}
+
+#endif
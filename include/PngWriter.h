@@ -0,0 +1,67 @@
+#pragma once
+
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <SFML/Graphics/Image.hpp>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// PNG encoder for rendered pages. A page only holds the highlighting colors
+// and their antialiased edges, when that is at most 256 colors it is written
+// as indexed color with the smallest bit depth, larger palettes can be
+// quantized. Scanlines are filtered and deflated in pieces on several threads.
+// Images too large to hold at once are streamed band by band as RGBA, a
+// palette would need every row up front.
+class WorkerPool;
+
+class PngWriter
+{
+private:
+	int m_level;
+	std::size_t m_threads;
+	bool m_quantize; // Pages of more colors are reduced to a palette instead of written as RGBA
+	std::unique_ptr<WorkerPool> m_pool; // Started once, every image and band reuses its threads
+	std::size_t m_colorCount;
+	// Streamed image
+	std::ofstream m_file;
+	std::string m_filePath;
+	unsigned m_width;
+	unsigned m_height;
+	unsigned m_rowsWritten;
+	std::uint32_t m_adler;
+	std::vector<std::uint8_t> m_window;      // Last scanlines, the dictionary of the next band
+	std::vector<std::uint8_t> m_previousRow; // Last row of pixels, filters look above it
+public:
+	// Levels go from 0 (stored) to 9 (smallest)
+	explicit PngWriter(int level = 6, std::size_t threads = 1, bool quantize = false);
+	~PngWriter();
+
+	PngWriter(const PngWriter&) = delete;
+
+	PngWriter& operator=(const PngWriter&) = delete;
+
+	bool saveToFile(const sf::Image& image, const std::string& filePath);
+
+	std::vector<std::uint8_t> encode(const sf::Uint8* pixels, unsigned width, unsigned height);
+
+	// Starts a streamed image, its rows are added from the top with writeRows
+	bool open(const std::string& filePath, unsigned width, unsigned height);
+
+	// Compresses and writes the next rows, only the rows of one band and the
+	// deflate window are held. False once every row was written.
+	bool writeRows(const sf::Uint8* pixels, unsigned rows);
+
+	// False when not every row was written, the partial file is removed then
+	bool close();
+
+	// Palette size of the last encoded image, 0 when it was written as RGBA
+	std::size_t getColorCount() const;
+
+	static std::uint32_t crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc = 0);
+};
+
+#endif
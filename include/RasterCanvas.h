@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef RASTER_CANVAS_H
+#define RASTER_CANVAS_H
+
+#include <SFML/Graphics.hpp>
+#include <memory>
+#include <vector>
+#include "PageGeometry.h"
+
+// Software counterpart of sf::RenderTexture. The geometry of a page is
+// composited on the CPU straight into an RGBA buffer, the only GPU access
+// left is reading back a glyph atlas after new glyphs were loaded into it.
+class RasterCanvas
+{
+private:
+	unsigned m_width;
+	unsigned m_height;
+	std::vector<sf::Uint8> m_pixels;
+	std::shared_ptr<const sf::Image> m_atlas;
+public:
+	RasterCanvas(unsigned width, unsigned height);
+
+	void clear(sf::Color color);
+
+	// Picks the atlas of the page, only called while the font is locked.
+	// Atlases are shared by every canvas of the run and only read back again
+	// once glyphs were added to the font texture.
+	void prepare(const PageGeometry& page);
+
+	// Strips of a page are drawn with the page shifted up by the strip top
+	void draw(const PageGeometry& page, const sf::Transform& transform = sf::Transform::Identity);
+
+	void draw(const sf::Vertex* vertices, std::size_t count, const sf::Transform& transform, const sf::Image* atlas);
+
+	// Copies the top height rows count - 1 times right below themselves, so
+	// a tile repeated down the page is only composited once
+	void repeatRows(unsigned height, unsigned count);
+
+	unsigned getWidth() const;
+
+	unsigned getHeight() const;
+
+	const sf::Uint8* getPixelsPtr() const;
+
+	sf::Image copyToImage() const;
+
+private:
+	void drawTriangle(const sf::Vertex& a, const sf::Vertex& b, const sf::Vertex& c, const sf::Image* atlas);
+
+	void drawRectangle(const sf::Vertex& topLeft, const sf::Vertex& bottomRight, const sf::Image* atlas);
+
+	void blend(std::size_t pixel, sf::Color color);
+};
+
+#endif
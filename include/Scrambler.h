@@ -6,18 +6,120 @@
 #include <vector>
 #include <random>
 #include <string>
+#include <string_view>
 #include <istream>
+#include <iterator>
+#include "MappedFile.h"
+
+// Lines of a scrambler in scrambled order. Only the permutation is owned,
+// the lines are read from the scrambler which has to outlive the view.
+class Scrambling
+{
+public:
+	class const_iterator
+	{
+	private:
+		const std::vector<std::string_view>* m_lines;
+		std::vector<std::size_t>::const_iterator m_index;
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = std::string_view;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const std::string_view*;
+		using reference = const std::string_view&;
+
+		const_iterator(const std::vector<std::string_view>* lines, std::vector<std::size_t>::const_iterator index)
+			: m_lines(lines),
+			m_index(index) {
+
+		}
+
+		reference operator*() const
+		{
+			return (*m_lines)[*m_index];
+		}
+
+		pointer operator->() const
+		{
+			return &(*m_lines)[*m_index];
+		}
+
+		const_iterator& operator++()
+		{
+			++m_index;
+			return *this;
+		}
+
+		const_iterator operator++(int)
+		{
+			const_iterator copy(*this);
+			++m_index;
+			return copy;
+		}
+
+		const_iterator& operator--()
+		{
+			--m_index;
+			return *this;
+		}
+
+		const_iterator operator+(difference_type offset) const
+		{
+			return { m_lines, m_index + offset };
+		}
+
+		difference_type operator-(const const_iterator& other) const
+		{
+			return m_index - other.m_index;
+		}
+
+		bool operator==(const const_iterator& other) const
+		{
+			return m_index == other.m_index;
+		}
+
+		bool operator!=(const const_iterator& other) const
+		{
+			return m_index != other.m_index;
+		}
+	};
+private:
+	const std::vector<std::string_view>* m_lines;
+	std::vector<std::size_t> m_order;
+public:
+	Scrambling(const std::vector<std::string_view>& lines, std::vector<std::size_t> order);
+
+	std::size_t size() const;
+
+	bool empty() const;
+
+	const std::string_view& operator[](std::size_t index) const;
+
+	const std::vector<std::size_t>& getOrder() const;
+
+	const_iterator begin() const;
+
+	const_iterator end() const;
+};
 
 class Scrambler
 {
 private:
 	mutable std::mt19937 m_engine;
 	std::vector<bool> m_markings;
-	std::vector<std::string> m_lines;
+	MappedFile m_file;
+	std::string m_buffer; // Contents read from a stream, files stay mapped instead
+	std::vector<std::string_view> m_lines; // Views into the mapping or the buffer
 	int m_difficulty;
 public:
 	Scrambler(const std::string& filePath, int difficulty);
 
+	// Lines are views into m_buffer, a copy or move would leave them
+	// pointing into the old one
+	Scrambler(const Scrambler&) = delete;
+
+	Scrambler& operator=(const Scrambler&) = delete;
+
 	void loadFromFile(const std::string& filePath);
 
 	void loadFromStream(std::istream& stream);
@@ -30,12 +132,16 @@ public:
 
 	void markLines(std::size_t start, std::size_t end, bool value);
 
-	const std::vector<std::string>& getLines() const;
+	const std::vector<std::string_view>& getLines() const;
+
+	std::vector<std::size_t> getPermutation() const;
 
-	std::vector<std::string> getScrambling() const;
+	Scrambling getScrambling() const;
 
 private:
-	void scramble(std::vector<std::string>::iterator begin, std::vector<std::string>::iterator end) const;
+	void loadFromData(std::string_view data);
+
+	void scramble(std::vector<std::size_t>::iterator begin, std::vector<std::size_t>::iterator end) const;
 
 };
 
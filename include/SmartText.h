@@ -4,6 +4,7 @@
 #define MGUI_SMART_TEXT_H
 
 #include <SFML\Graphics\Text.hpp>
+#include <memory_resource>
 #include <vector>
 #include <optional>
 
@@ -67,18 +68,26 @@ public:
 
 		ChunkData& highlighter(sf::Color color);
 	};
+
+	// Attributes for the characters [start, start + data.length)
+	struct Span {
+		std::size_t start;
+		ChunkData data;
+	};
 private:
 	//Deque for text objects and one whole string
 	//Deque for text Data objects to hold information and one whole vertex array
 	mutable bool m_needsUpdate;
+	mutable std::size_t m_staleChunk; // First chunk whose index is out of date
 	const sf::Font* m_font;
 	sf::String m_string;
 	mutable sf::FloatRect m_bounds;
-	mutable std::vector<Chunk> m_chunks;
-	mutable std::vector<sf::Vertex> m_vertices;
-	mutable std::vector<sf::Vertex> m_outlineVertices;
+	mutable std::pmr::vector<Chunk> m_chunks;
+	mutable std::pmr::vector<sf::Vertex> m_vertices;
+	mutable std::pmr::vector<sf::Vertex> m_outlineVertices;
 public:
-	SmartText(const sf::String& text, const sf::Font& font);
+	// Chunks and vertices are allocated from resource, which has to outlive the text
+	SmartText(const sf::String& text, const sf::Font& font, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
 	SmartText();
 	~SmartText();
 
@@ -112,6 +121,8 @@ public:
 
 	void setProperties(std::size_t start, std::size_t length, const ChunkData& data);
 
+	void applySpans(const std::pmr::vector<Span>& spans);
+
 	void setString(const sf::String& text);
 
 	void setHighlight(sf::Color color);
@@ -138,6 +149,8 @@ public:
 
 	const Chunk& getChunk(std::size_t index) const;
 
+	const std::pmr::vector<sf::Vertex>& getVertices() const;
+
 	const std::size_t getChunkIndex(std::size_t subIndex) const;
 
 	sf::Vector2f findLocalCharacterPos(std::size_t subIndex) const;
@@ -155,12 +168,18 @@ private:
 
 	void ensureGeometryUpdate() const;
 
+	void ensureChunkIndices() const;
+
+	void invalidateChunkIndices(std::size_t chunk) const;
+
 	void updateChunks(std::size_t start);
 
 	void insertChunk(std::size_t subIndex, const Chunk& chunk);
 
 	void replaceChunk(std::size_t subIndex, const ChunkData& chunk);
 
+	static void applyChunkData(Chunk& chunk, const ChunkData& chunkData);
+
 	void eraseChunk(std::size_t subIndex, std::size_t length);
 };
 
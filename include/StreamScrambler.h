@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef STREAM_SCRAMBLER_H
+#define STREAM_SCRAMBLER_H
+
+#include <vector>
+#include <random>
+#include <string>
+#include <cstdint>
+#include "MappedFile.h"
+
+// Scrambler for inputs too large to keep as strings. The file stays mapped,
+// only an offset index of its lines and the fixed markings are held in
+// memory and the index is shuffled instead of the lines themselves.
+class StreamScrambler
+{
+private:
+	struct Line {
+		std::uint64_t offset;
+		std::size_t length;
+	};
+
+	std::mt19937 m_engine;
+	MappedFile m_file;
+	std::vector<Line> m_lines;
+	std::vector<bool> m_markings;
+	int m_difficulty;
+public:
+	StreamScrambler(int difficulty);
+
+	bool loadFromFile(const std::string& filePath);
+
+	void seed();
+
+	void seed(unsigned seed);
+
+	std::size_t getLineCount() const;
+
+	void scramble();
+
+	bool saveScrambling(const std::string& filePath) const;
+
+private:
+	void markLines(std::size_t start, std::size_t end, bool value);
+};
+
+#endif
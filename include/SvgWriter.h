@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H
+
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Highlighter.h"
+
+// Page written as SVG text runs and rectangles instead of pixels. Every word
+// is placed at the pen position the raster path gives it, the viewer only
+// lays out the glyphs within a word. The font file is referenced next to the
+// page, or embedded so a printed page doesn't depend on any other file.
+class SvgWriter
+{
+private:
+	unsigned m_width;
+	unsigned m_height;
+	float m_ppi;
+	float m_tileHeight;
+	unsigned m_tileCount;
+	std::size_t m_runCount;
+	std::string m_body;
+public:
+	// Coordinates are in pixels at ppi, the page itself is sized in inches
+	SvgWriter(unsigned width, unsigned height, float ppi);
+
+	void addLine(std::string_view line, const std::vector<HighlightSpan>& spans, const sf::Font& font, unsigned characterSize, sf::Vector2f baseline);
+
+	void addRectangle(sf::FloatRect rect, sf::Color color);
+
+	// Everything added is drawn count times, height apart
+	void setTiles(float height, unsigned count);
+
+	// The font is referenced by its path relative to the page unless it is
+	// embedded, which adds about a third more than the font file to every page
+	bool saveToFile(const std::string& filePath, const std::string& fontPath, bool embedFont) const;
+
+	std::size_t getRunCount() const;
+
+	// @font-face rule holding the embedded font file, read once per path for
+	// the whole run
+	static const std::string& getFontFace(const std::string& fontPath);
+};
+
+#endif
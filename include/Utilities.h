@@ -8,6 +8,7 @@
 #include <sstream>
 #include <optional>
 #include <iostream>
+#include <random>
 #include <SFML/Graphics/Rect.hpp>
 
 inline bool endsWith(const std::string& data, const std::string& ending) {
@@ -78,6 +79,20 @@ std::optional<T> parseType(const std::string& data)
 	return std::nullopt;
 }
 
+// Seed of a variant, the first variant keeps the given seed so that any
+// variant can be regenerated on its own by passing its seed.
+inline unsigned deriveSeed(unsigned seed, std::size_t variant)
+{
+	if (variant == 0) {
+		return seed;
+	}
+
+	std::seed_seq sequence{ seed, static_cast<unsigned>(variant) };
+	unsigned derived;
+	sequence.generate(&derived, &derived + 1);
+	return derived;
+}
+
 inline void exitPrompt()
 {
 	std::cout << "Press enter to exit...";
@@ -0,0 +1,47 @@
+#pragma once
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// Fixed amount of worker threads consuming a bounded task queue.
+// Submitting blocks while the queue is full so a large directory never
+// queues more work than the workers can keep up with.
+class WorkerPool
+{
+public:
+	using Task = std::function<void()>;
+private:
+	std::vector<std::thread> m_workers;
+	std::queue<Task> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_taskReady;
+	std::condition_variable m_slotReady;
+	std::condition_variable m_idle;
+	std::size_t m_capacity;
+	std::size_t m_running;
+	bool m_stopping;
+public:
+	WorkerPool(std::size_t workers, std::size_t capacity = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	void submit(Task task);
+
+	void wait();
+
+	std::size_t getWorkerCount() const;
+
+private:
+	void work();
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "CharClass.h"
+#include <algorithm>
+#include <bitset>
+
+#if CHAR_CLASS_SIMD && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define CHAR_CLASS_SSE2 1
+#include <emmintrin.h>
+#endif
+#if CHAR_CLASS_SIMD && defined(__AVX2__)
+#define CHAR_CLASS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+#if CHAR_CLASS_AVX2
+	constexpr std::size_t LaneSize = 32;
+#elif CHAR_CLASS_SSE2
+	constexpr std::size_t LaneSize = 16;
+#else
+	constexpr std::size_t LaneSize = 8;
+#endif
+
+	// Classes of the characters of one lane, bit i stands for character i
+	struct CharMasks
+	{
+		std::uint64_t space;   // ' '
+		std::uint64_t tab;     // '\t'
+		std::uint64_t newline; // '\n'
+		std::uint64_t other;   // '\r', '\v' and '\f'
+
+		std::uint64_t blank() const
+		{
+			return space | tab;
+		}
+
+		std::uint64_t whitespace() const
+		{
+			return space | tab | newline | other;
+		}
+	};
+
+	std::size_t countBits(std::uint64_t value)
+	{
+		return std::bitset<64>(value).count();
+	}
+
+	// Index of the lowest set bit, value must not be 0
+	std::size_t lowestBit(std::uint64_t value)
+	{
+		return countBits((value & (~value + 1)) - 1);
+	}
+
+	std::uint64_t lowBits(std::size_t count)
+	{
+		return count >= 64 ? ~std::uint64_t{ 0 } : (std::uint64_t{ 1 } << count) - 1;
+	}
+
+	// Classifies exactly one lane of bytes, only the low LaneSize bits are set.
+	// Masks a caller does not read are dropped by the compiler.
+	inline CharMasks classifyLane(const char* bytes)
+	{
+#if CHAR_CLASS_AVX2
+		const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes));
+		auto mask = [&value](char ch) {
+			return _mm256_cmpeq_epi8(value, _mm256_set1_epi8(ch));
+		};
+		auto bits = [](__m256i mask) {
+			return std::uint64_t{ static_cast<std::uint32_t>(_mm256_movemask_epi8(mask)) };
+		};
+		return { bits(mask(' ')), bits(mask('\t')), bits(mask('\n')),
+			bits(_mm256_or_si256(mask('\r'), _mm256_or_si256(mask('\v'), mask('\f')))) };
+#elif CHAR_CLASS_SSE2
+		const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes));
+		auto mask = [&value](char ch) {
+			return _mm_cmpeq_epi8(value, _mm_set1_epi8(ch));
+		};
+		auto bits = [](__m128i mask) {
+			return std::uint64_t{ static_cast<std::uint32_t>(_mm_movemask_epi8(mask)) };
+		};
+		return { bits(mask(' ')), bits(mask('\t')), bits(mask('\n')),
+			bits(_mm_or_si128(mask('\r'), _mm_or_si128(mask('\v'), mask('\f')))) };
+#else
+		CharMasks masks{ 0, 0, 0, 0 };
+		for (std::size_t index = 0; index != LaneSize; ++index) {
+			const std::uint64_t bit = std::uint64_t{ 1 } << index;
+			switch (bytes[index])
+			{
+			case ' ':  masks.space |= bit;   break;
+			case '\t': masks.tab |= bit;     break;
+			case '\n': masks.newline |= bit; break;
+			case '\r':
+			case '\v':
+			case '\f': masks.other |= bit;   break;
+			default: break;
+			}
+		}
+		return masks;
+#endif
+	}
+
+	// Codepoints are narrowed to bytes first, anything outside of ASCII ends
+	// up as a byte that is not whitespace.
+	void narrow(const std::uint32_t* data, std::size_t size, char* bytes)
+	{
+		std::size_t index = 0;
+#if CHAR_CLASS_SSE2
+		for (; index + 16 <= size; index += 16) {
+			const __m128i* source = reinterpret_cast<const __m128i*>(data + index);
+			const __m128i low = _mm_packs_epi32(_mm_loadu_si128(source), _mm_loadu_si128(source + 1));
+			const __m128i high = _mm_packs_epi32(_mm_loadu_si128(source + 2), _mm_loadu_si128(source + 3));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + index), _mm_packus_epi16(low, high));
+		}
+#endif
+		for (; index != size; ++index) {
+			bytes[index] = data[index] < 0x80 ? static_cast<char>(data[index]) : '\x7f';
+		}
+	}
+
+	inline CharMasks classifyLane(const std::uint32_t* data)
+	{
+		char bytes[LaneSize];
+		narrow(data, LaneSize, bytes);
+		return classifyLane(bytes);
+	}
+
+	bool isBlank(std::uint32_t ch)
+	{
+		return ch == ' ' || ch == '\t';
+	}
+
+	bool isWhitespace(std::uint32_t ch)
+	{
+		return isBlank(ch) || ch == '\n' || ch == '\r' || ch == '\v' || ch == '\f';
+	}
+
+	// Whole lanes are tested at once and the scan stops at the first lane
+	// holding something else, the remainder shorter than a lane is scalar.
+	template<typename Character>
+	BlankRun findBlankRun(const Character* data, std::size_t size)
+	{
+		BlankRun run{ 0, 0 };
+		for (; run.length + LaneSize <= size; run.length += LaneSize) {
+			const CharMasks lane = classifyLane(data + run.length);
+			const std::uint64_t stop = ~lane.blank() & lowBits(LaneSize);
+			if (stop) {
+				const std::size_t length = lowestBit(stop);
+				run.tabs += countBits(lane.tab & lowBits(length));
+				run.length += length;
+				return run;
+			}
+			run.tabs += countBits(lane.tab);
+		}
+		for (; run.length != size && isBlank(static_cast<std::uint32_t>(data[run.length])); ++run.length) {
+			run.tabs += data[run.length] == '\t';
+		}
+		return run;
+	}
+}
+
+BlankRun CharClass::blankRun(const char* data, std::size_t size)
+{
+	return findBlankRun(data, size);
+}
+
+BlankRun CharClass::blankRun(const std::uint32_t* data, std::size_t size)
+{
+	return findBlankRun(data, size);
+}
+
+std::size_t CharClass::skipWhitespace(const char* data, std::size_t size)
+{
+	std::size_t index = 0;
+	for (; index + LaneSize <= size; index += LaneSize) {
+		const std::uint64_t stop = ~classifyLane(data + index).whitespace() & lowBits(LaneSize);
+		if (stop) {
+			return index + lowestBit(stop);
+		}
+	}
+	while (index != size && isWhitespace(static_cast<unsigned char>(data[index]))) {
+		++index;
+	}
+	return index;
+}
@@ -1,20 +1,174 @@
 #include <vector>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <fstream>
 #include <iostream>
 #include "CodeState.h"
 
 namespace
 {
-	std::vector<std::string> states;
+#if CODE_STATE_PROFILING
+	using Clock = std::chrono::steady_clock;
+	using Counter = std::pair<std::string, std::size_t>;
+
+	struct State
+	{
+		std::string name;
+		Clock::time_point start;
+		std::vector<Counter> counters;
+	};
+
+	// Finished stage as written to the profile, times are in microseconds
+	// since the start of the run.
+	struct Event
+	{
+		std::string name;
+		std::size_t thread;
+		std::size_t depth;
+		long long start;
+		long long duration;
+		std::vector<Counter> counters;
+	};
+
+	const Clock::time_point epoch = Clock::now();
+	std::atomic<std::size_t> threads{ 0 };
+	thread_local const std::size_t threadIndex = threads++;
+	std::atomic<bool> recording{ false };
+	std::mutex eventsMutex;
+	std::vector<Event> events;
+
+	long long microseconds(Clock::duration duration)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+	}
+
+	void writeString(std::ostream& stream, const std::string& string)
+	{
+		stream << '"';
+		for (char ch : string) {
+			switch (ch)
+			{
+			case '"':  stream << "\\\""; break;
+			case '\\': stream << "\\\\"; break;
+			case '\n': stream << "\\n";  break;
+			case '\t': stream << "\\t";  break;
+			default:
+				if (static_cast<unsigned char>(ch) < 0x20) {
+					stream << ' ';
+				}
+				else {
+					stream << ch;
+				}
+				break;
+			}
+		}
+		stream << '"';
+	}
+#else
+	struct State
+	{
+		std::string name;
+	};
+#endif
+
+	// Every worker keeps its own stack, only the console is shared
+	thread_local std::vector<State> states;
+	std::mutex output;
 }
 
 void pushCodeState(std::string_view state)
 {
-	std::cout << "[STARTING]:  " << state << std::endl;
-	states.push_back(std::string{ state });
+	{
+		std::lock_guard<std::mutex> lock(output);
+		std::cout << "[STARTING]:  " << state << '\n';
+	}
+#if CODE_STATE_PROFILING
+	states.push_back({ std::string{ state }, Clock::now(), {} });
+#else
+	states.push_back({ std::string{ state } });
+#endif
 }
 
 void popCodeState()
 {
-	std::cout << "[COMPLETED]: " << states.back() << std::endl << std::endl;
+#if CODE_STATE_PROFILING
+	const Clock::time_point end = Clock::now();
+	State& state = states.back();
+	const long long duration = microseconds(end - state.start);
+
+	{
+		std::lock_guard<std::mutex> lock(output);
+		std::cout << "[COMPLETED]: " << state.name << " (" << duration / 1000.0 << " ms";
+		for (auto& counter : state.counters) {
+			std::cout << ", " << counter.first << " = " << counter.second;
+		}
+		std::cout << ")\n\n";
+	}
+
+	if (recording) {
+		Event event{ std::move(state.name), threadIndex, states.size() - 1, microseconds(state.start - epoch), duration, std::move(state.counters) };
+		std::lock_guard<std::mutex> lock(eventsMutex);
+		events.push_back(std::move(event));
+	}
+#else
+	{
+		std::lock_guard<std::mutex> lock(output);
+		std::cout << "[COMPLETED]: " << states.back().name << "\n\n";
+	}
+#endif
 	states.pop_back();
 }
+
+#if CODE_STATE_PROFILING
+void countCodeState(std::string_view counter, std::size_t value)
+{
+	if (states.empty()) {
+		return;
+	}
+
+	auto& counters = states.back().counters;
+	for (auto& existing : counters) {
+		if (existing.first == counter) {
+			existing.second += value;
+			return;
+		}
+	}
+	counters.emplace_back(std::string{ counter }, value);
+}
+
+void enableCodeProfile()
+{
+	recording = true;
+}
+
+bool saveCodeProfile(const std::string& filePath)
+{
+	std::ofstream stream(filePath, std::ofstream::trunc | std::ofstream::out);
+	if (!stream) {
+		return false;
+	}
+
+	// Chrome trace event format, complete events nest by thread and time
+	std::lock_guard<std::mutex> lock(eventsMutex);
+	stream << "{\"traceEvents\":[\n";
+	for (std::size_t index = 0; index != events.size(); ++index) {
+		const Event& event = events[index];
+		stream << "{\"name\":";
+		writeString(stream, event.name);
+		stream << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+			<< ",\"ts\":" << event.start << ",\"dur\":" << event.duration
+			<< ",\"args\":{\"depth\":" << event.depth;
+		for (auto& counter : event.counters) {
+			stream << ',';
+			writeString(stream, counter.first);
+			stream << ':' << counter.second;
+		}
+		stream << "}}" << (index + 1 != events.size() ? ",\n" : "\n");
+	}
+	stream << "],\"displayTimeUnit\":\"ms\"}\n";
+
+	stream.flush();
+	return static_cast<bool>(stream);
+}
+#endif
@@ -0,0 +1,718 @@
+#include "Deflate.h"
+#include <algorithm>
+#include <array>
+
+namespace
+{
+	constexpr std::size_t MinimumMatch = 3;
+	constexpr std::size_t MaximumMatch = 258;
+	constexpr std::size_t WindowMask = Deflate::WindowSize - 1;
+	constexpr unsigned HashBits = 15;
+	constexpr std::size_t BlockSymbols = std::size_t{ 1 } << 14;
+	constexpr std::size_t MaximumStored = 65535;
+
+	constexpr std::size_t LiteralCodes = 286;
+	constexpr std::size_t DistanceCodes = 30;
+	constexpr std::size_t LengthCodes = 19;
+	constexpr std::uint16_t EndOfBlock = 256;
+
+	// zlib's configuration table. Levels 1 to 3 take the first match and only
+	// index the positions inside matches up to lazy bytes long, the others
+	// look for a longer match at the next position unless the current one
+	// reaches lazy, and follow a quarter of the chain once it reaches good.
+	struct LevelParameters
+	{
+		std::size_t good;
+		std::size_t lazy;
+		std::size_t nice;
+		std::size_t chain;
+	};
+
+	constexpr LevelParameters levels[] = {
+		{ 0, 0, 0, 0 }, { 4, 4, 8, 4 }, { 4, 5, 16, 8 }, { 4, 6, 32, 32 }, { 4, 4, 16, 16 },
+		{ 8, 16, 32, 32 }, { 8, 16, 128, 128 }, { 8, 32, 128, 256 }, { 32, 128, 258, 1024 }, { 32, 258, 258, 4096 }
+	};
+	constexpr int LazyLevel = 4;
+
+	// Matches of the minimum length this far back cost more than literals
+	constexpr std::size_t TooFar = 4096;
+
+	constexpr std::uint16_t lengthBase[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+	constexpr std::uint8_t lengthExtra[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+	constexpr std::uint16_t distanceBase[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+	};
+	constexpr std::uint8_t distanceExtra[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+	constexpr std::uint8_t lengthOrder[LengthCodes] = {
+		16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
+	};
+
+	// Match length to length code, 257 is added when written
+	constexpr auto lengthCodes = [] {
+		std::array<std::uint8_t, MaximumMatch + 1> codes{};
+		std::uint8_t code = 0;
+		for (std::size_t length = MinimumMatch; length <= MaximumMatch; ++length) {
+			while (code + 1 < 29 && lengthBase[code + 1] <= length) {
+				++code;
+			}
+			codes[length] = code;
+		}
+		return codes;
+	}();
+
+	// Distances up to 256 are looked up directly, the codes above start on
+	// multiples of 128 plus one
+	constexpr auto nearDistanceCodes = [] {
+		std::array<std::uint8_t, 257> codes{};
+		std::uint8_t code = 0;
+		for (std::size_t distance = 1; distance <= 256; ++distance) {
+			while (code + 1 < 30 && distanceBase[code + 1] <= distance) {
+				++code;
+			}
+			codes[distance] = code;
+		}
+		return codes;
+	}();
+
+	constexpr auto farDistanceCodes = [] {
+		std::array<std::uint8_t, 256> codes{};
+		std::uint8_t code = 0;
+		for (std::size_t distance = 257; distance <= Deflate::WindowSize; distance += 128) {
+			while (code + 1 < 30 && distanceBase[code + 1] <= distance) {
+				++code;
+			}
+			codes[(distance - 1) >> 7] = code;
+		}
+		return codes;
+	}();
+
+	std::size_t getDistanceCode(std::size_t distance)
+	{
+		return distance <= 256 ? nearDistanceCodes[distance] : farDistanceCodes[(distance - 1) >> 7];
+	}
+
+	class BitWriter
+	{
+	private:
+		std::vector<std::uint8_t>& m_output;
+		std::uint64_t m_bits;
+		unsigned m_count;
+	public:
+		explicit BitWriter(std::vector<std::uint8_t>& output)
+			: m_output(output),
+			m_bits(0),
+			m_count(0)
+		{
+
+		}
+
+		void write(std::uint32_t value, unsigned count)
+		{
+			m_bits |= static_cast<std::uint64_t>(value) << m_count;
+			m_count += count;
+			while (m_count >= 8) {
+				m_output.push_back(static_cast<std::uint8_t>(m_bits));
+				m_bits >>= 8;
+				m_count -= 8;
+			}
+		}
+
+		void align()
+		{
+			if (m_count) {
+				write(0, 8 - m_count);
+			}
+		}
+
+		// Only on a byte boundary
+		void writeBytes(const std::uint8_t* data, std::size_t size)
+		{
+			m_output.insert(m_output.end(), data, data + size);
+		}
+	};
+
+	// Length limited Huffman code lengths, unused symbols get a length of 0
+	void buildLengths(const std::uint32_t* frequencies, std::size_t count, unsigned maximum, std::uint8_t* lengths)
+	{
+		std::vector<std::pair<std::uint32_t, std::uint16_t>> leaves;
+		for (std::size_t symbol = 0; symbol != count; ++symbol) {
+			lengths[symbol] = 0;
+			if (frequencies[symbol]) {
+				leaves.emplace_back(frequencies[symbol], static_cast<std::uint16_t>(symbol));
+			}
+		}
+		if (leaves.size() == 1) {
+			lengths[leaves.front().second] = 1;
+		}
+		if (leaves.size() < 2) {
+			return;
+		}
+		std::sort(leaves.begin(), leaves.end());
+
+		// Two queue construction: leaves are sorted and joined nodes are made
+		// in order of weight, nodes are numbered leaves first.
+		const std::size_t leafCount = leaves.size();
+		std::vector<std::uint64_t> weights(leafCount * 2 - 1);
+		std::vector<std::size_t> parents(leafCount * 2 - 1);
+		for (std::size_t leaf = 0; leaf != leafCount; ++leaf) {
+			weights[leaf] = leaves[leaf].first;
+		}
+		std::size_t nextLeaf = 0;
+		std::size_t nextNode = leafCount;
+		auto lightest = [&](std::size_t node) {
+			if (nextLeaf != leafCount && (nextNode == node || weights[nextLeaf] <= weights[nextNode])) {
+				return nextLeaf++;
+			}
+			return nextNode++;
+		};
+		for (std::size_t node = leafCount; node != weights.size(); ++node) {
+			const std::size_t left = lightest(node);
+			const std::size_t right = lightest(node);
+			weights[node] = weights[left] + weights[right];
+			parents[left] = node;
+			parents[right] = node;
+		}
+
+		// Children are numbered below their parent, the root is last
+		std::vector<unsigned> depths(weights.size(), 0);
+		std::array<std::size_t, 64> lengthCounts{};
+		for (std::size_t node = weights.size() - 1; node-- != 0; ) {
+			depths[node] = depths[parents[node]] + 1;
+			if (node < leafCount) {
+				++lengthCounts[std::min(depths[node], maximum)];
+			}
+		}
+
+		// Codes that were cut to the maximum oversubscribe it, a longer code
+		// is traded for two codes one bit longer until the code is complete
+		std::uint64_t total = 0;
+		for (unsigned length = maximum; length != 0; --length) {
+			total += static_cast<std::uint64_t>(lengthCounts[length]) << (maximum - length);
+		}
+		while (total != std::uint64_t{ 1 } << maximum) {
+			--lengthCounts[maximum];
+			for (unsigned length = maximum - 1; length != 0; --length) {
+				if (lengthCounts[length]) {
+					--lengthCounts[length];
+					lengthCounts[length + 1] += 2;
+					break;
+				}
+			}
+			--total;
+		}
+
+		// The rarest symbols get the longest codes
+		std::size_t leaf = 0;
+		for (unsigned length = maximum; length != 0; --length) {
+			for (std::size_t index = 0; index != lengthCounts[length]; ++index) {
+				lengths[leaves[leaf++].second] = static_cast<std::uint8_t>(length);
+			}
+		}
+	}
+
+	// Canonical codes, bit reversed since deflate writes them from the top bit
+	void buildCodes(const std::uint8_t* lengths, std::size_t count, std::uint16_t* codes)
+	{
+		std::array<std::uint16_t, 16> lengthCounts{};
+		for (std::size_t symbol = 0; symbol != count; ++symbol) {
+			++lengthCounts[lengths[symbol]];
+		}
+		lengthCounts[0] = 0;
+
+		std::array<std::uint16_t, 16> next{};
+		for (std::size_t length = 1; length != 16; ++length) {
+			next[length] = static_cast<std::uint16_t>((next[length - 1] + lengthCounts[length - 1]) << 1);
+		}
+
+		for (std::size_t symbol = 0; symbol != count; ++symbol) {
+			const unsigned length = lengths[symbol];
+			std::uint16_t code = length ? next[length]++ : 0;
+			std::uint16_t reversed = 0;
+			for (unsigned bit = 0; bit != length; ++bit) {
+				reversed = static_cast<std::uint16_t>((reversed << 1) | (code & 1));
+				code >>= 1;
+			}
+			codes[symbol] = reversed;
+		}
+	}
+
+	struct Symbol
+	{
+		std::uint16_t length; // 0 for a literal
+		std::uint16_t value;  // Literal or distance
+	};
+
+	// Code lengths of the literal and distance codes, run length encoded
+	// with the repeat codes 16, 17 and 18
+	struct LengthRun
+	{
+		std::uint8_t code;
+		std::uint8_t extra;
+	};
+
+	void encodeLengths(const std::uint8_t* lengths, std::size_t count, std::vector<LengthRun>& runs, std::uint32_t* frequencies)
+	{
+		for (std::size_t index = 0; index != count; ) {
+			const std::uint8_t length = lengths[index];
+			std::size_t run = 1;
+			while (index + run != count && lengths[index + run] == length) {
+				++run;
+			}
+			index += run;
+
+			if (length == 0) {
+				while (run >= 11) {
+					const std::size_t repeat = std::min<std::size_t>(run, 138);
+					runs.push_back({ 18, static_cast<std::uint8_t>(repeat - 11) });
+					run -= repeat;
+				}
+				if (run >= 3) {
+					runs.push_back({ 17, static_cast<std::uint8_t>(run - 3) });
+					run = 0;
+				}
+			}
+			else {
+				runs.push_back({ length, 0 });
+				--run;
+				while (run >= 3) {
+					const std::size_t repeat = std::min<std::size_t>(run, 6);
+					runs.push_back({ 16, static_cast<std::uint8_t>(repeat - 3) });
+					run -= repeat;
+				}
+			}
+			for (; run != 0; --run) {
+				runs.push_back({ length, 0 });
+			}
+		}
+		for (auto& run : runs) {
+			++frequencies[run.code];
+		}
+	}
+
+	class BlockEncoder
+	{
+	private:
+		const std::uint8_t* m_data;
+		BitWriter m_writer;
+		std::vector<Symbol> m_symbols;
+		std::array<std::uint32_t, LiteralCodes> m_literalFrequencies;
+		std::array<std::uint32_t, DistanceCodes> m_distanceFrequencies;
+		std::uint64_t m_extraBits;
+		std::size_t m_blockStart;
+	public:
+		BlockEncoder(const std::uint8_t* data, std::size_t start, std::vector<std::uint8_t>& output)
+			: m_data(data),
+			m_writer(output),
+			m_literalFrequencies{},
+			m_distanceFrequencies{},
+			m_extraBits(0),
+			m_blockStart(start)
+		{
+			m_symbols.reserve(BlockSymbols);
+		}
+
+		bool isFull() const
+		{
+			return m_symbols.size() == BlockSymbols;
+		}
+
+		bool isEmpty() const
+		{
+			return m_symbols.empty();
+		}
+
+		void addLiteral(std::uint8_t literal)
+		{
+			m_symbols.push_back({ 0, literal });
+			++m_literalFrequencies[literal];
+		}
+
+		void addMatch(std::size_t length, std::size_t distance)
+		{
+			m_symbols.push_back({ static_cast<std::uint16_t>(length), static_cast<std::uint16_t>(distance) });
+			const std::size_t lengthCode = lengthCodes[length];
+			const std::size_t distanceCode = getDistanceCode(distance);
+			++m_literalFrequencies[257 + lengthCode];
+			++m_distanceFrequencies[distanceCode];
+			m_extraBits += lengthExtra[lengthCode] + distanceExtra[distanceCode];
+		}
+
+		// Writes the symbols of data[blockStart, end) as the cheapest of a
+		// dynamic, fixed or stored block
+		void flush(std::size_t end, bool final)
+		{
+			m_literalFrequencies[EndOfBlock] = 1;
+
+			std::array<std::uint8_t, LiteralCodes> literalLengths;
+			std::array<std::uint8_t, DistanceCodes> distanceLengths;
+			buildLengths(m_literalFrequencies.data(), LiteralCodes, 15, literalLengths.data());
+			buildLengths(m_distanceFrequencies.data(), DistanceCodes, 15, distanceLengths.data());
+			// At least one distance code is sent, even when none is used
+			if (std::all_of(distanceLengths.begin(), distanceLengths.end(), [](std::uint8_t length) { return length == 0; })) {
+				distanceLengths[0] = 1;
+			}
+
+			std::size_t literalCount = LiteralCodes;
+			while (literalCount > 257 && literalLengths[literalCount - 1] == 0) {
+				--literalCount;
+			}
+			std::size_t distanceCount = DistanceCodes;
+			while (distanceCount > 1 && distanceLengths[distanceCount - 1] == 0) {
+				--distanceCount;
+			}
+
+			std::array<std::uint8_t, LiteralCodes + DistanceCodes> lengths;
+			std::copy_n(literalLengths.begin(), literalCount, lengths.begin());
+			std::copy_n(distanceLengths.begin(), distanceCount, lengths.begin() + literalCount);
+			std::vector<LengthRun> runs;
+			std::array<std::uint32_t, LengthCodes> runFrequencies{};
+			encodeLengths(lengths.data(), literalCount + distanceCount, runs, runFrequencies.data());
+			std::array<std::uint8_t, LengthCodes> runLengths;
+			buildLengths(runFrequencies.data(), LengthCodes, 7, runLengths.data());
+			std::size_t runCount = LengthCodes;
+			while (runCount > 4 && runLengths[lengthOrder[runCount - 1]] == 0) {
+				--runCount;
+			}
+
+			std::uint64_t dynamicBits = 3 + 14 + 3 * runCount + m_extraBits;
+			for (auto& run : runs) {
+				dynamicBits += runLengths[run.code] + (run.code == 16 ? 2 : run.code == 17 ? 3 : run.code == 18 ? 7 : 0);
+			}
+			std::uint64_t fixedBits = 3 + m_extraBits;
+			for (std::size_t symbol = 0; symbol != LiteralCodes; ++symbol) {
+				dynamicBits += static_cast<std::uint64_t>(m_literalFrequencies[symbol]) * literalLengths[symbol];
+				fixedBits += static_cast<std::uint64_t>(m_literalFrequencies[symbol]) * (symbol < 144 ? 8 : symbol < 256 ? 9 : symbol < 280 ? 7 : 8);
+			}
+			for (std::size_t symbol = 0; symbol != DistanceCodes; ++symbol) {
+				dynamicBits += static_cast<std::uint64_t>(m_distanceFrequencies[symbol]) * distanceLengths[symbol];
+				fixedBits += static_cast<std::uint64_t>(m_distanceFrequencies[symbol]) * 5;
+			}
+			const std::size_t size = end - m_blockStart;
+			const std::uint64_t storedBits = (size / MaximumStored + 1) * (3 + 7 + 32) + size * 8;
+
+			if (storedBits < std::min(dynamicBits, fixedBits)) {
+				writeStored(m_data + m_blockStart, size, final, m_writer);
+			}
+			else if (fixedBits <= dynamicBits) {
+				std::array<std::uint8_t, 288> fixedLiterals;
+				std::fill_n(fixedLiterals.begin(), 144, 8);
+				std::fill_n(fixedLiterals.begin() + 144, 112, 9);
+				std::fill_n(fixedLiterals.begin() + 256, 24, 7);
+				std::fill_n(fixedLiterals.begin() + 280, 8, 8);
+				std::array<std::uint8_t, DistanceCodes> fixedDistances;
+				fixedDistances.fill(5);
+
+				m_writer.write(final ? 1 : 0, 1);
+				m_writer.write(1, 2);
+				writeSymbols(fixedLiterals.data(), fixedLiterals.size(), fixedDistances.data());
+			}
+			else {
+				m_writer.write(final ? 1 : 0, 1);
+				m_writer.write(2, 2);
+				m_writer.write(static_cast<std::uint32_t>(literalCount - 257), 5);
+				m_writer.write(static_cast<std::uint32_t>(distanceCount - 1), 5);
+				m_writer.write(static_cast<std::uint32_t>(runCount - 4), 4);
+				for (std::size_t index = 0; index != runCount; ++index) {
+					m_writer.write(runLengths[lengthOrder[index]], 3);
+				}
+				std::array<std::uint16_t, LengthCodes> runCodes;
+				buildCodes(runLengths.data(), LengthCodes, runCodes.data());
+				for (auto& run : runs) {
+					m_writer.write(runCodes[run.code], runLengths[run.code]);
+					if (run.code >= 16) {
+						m_writer.write(run.extra, run.code == 16 ? 2 : run.code == 17 ? 3 : 7);
+					}
+				}
+				writeSymbols(literalLengths.data(), LiteralCodes, distanceLengths.data());
+			}
+
+			m_symbols.clear();
+			m_literalFrequencies.fill(0);
+			m_distanceFrequencies.fill(0);
+			m_extraBits = 0;
+			m_blockStart = end;
+		}
+
+		BitWriter& getWriter()
+		{
+			return m_writer;
+		}
+
+		static void writeStored(const std::uint8_t* data, std::size_t size, bool final, BitWriter& writer)
+		{
+			do {
+				const std::size_t length = std::min(size, MaximumStored);
+				size -= length;
+				writer.write(final && size == 0 ? 1 : 0, 1);
+				writer.write(0, 2);
+				writer.align();
+				writer.write(static_cast<std::uint32_t>(length), 16);
+				writer.write(static_cast<std::uint32_t>(~length & 0xFFFF), 16);
+				if (length) {
+					writer.writeBytes(data, length);
+					data += length;
+				}
+			} while (size != 0);
+		}
+
+	private:
+		// The fixed code is built from all 288 literal lengths, leaving out
+		// the two unused codes would shift the 9 bit codes
+		void writeSymbols(const std::uint8_t* literalLengths, std::size_t literalCount, const std::uint8_t* distanceLengths)
+		{
+			std::array<std::uint16_t, 288> literalCodes;
+			std::array<std::uint16_t, DistanceCodes> distanceCodes;
+			buildCodes(literalLengths, literalCount, literalCodes.data());
+			buildCodes(distanceLengths, DistanceCodes, distanceCodes.data());
+
+			for (auto& symbol : m_symbols) {
+				if (symbol.length == 0) {
+					m_writer.write(literalCodes[symbol.value], literalLengths[symbol.value]);
+					continue;
+				}
+				const std::size_t lengthCode = lengthCodes[symbol.length];
+				m_writer.write(literalCodes[257 + lengthCode], literalLengths[257 + lengthCode]);
+				m_writer.write(symbol.length - lengthBase[lengthCode], lengthExtra[lengthCode]);
+
+				const std::size_t distanceCode = getDistanceCode(symbol.value);
+				m_writer.write(distanceCodes[distanceCode], distanceLengths[distanceCode]);
+				m_writer.write(symbol.value - distanceBase[distanceCode], distanceExtra[distanceCode]);
+			}
+			m_writer.write(literalCodes[EndOfBlock], literalLengths[EndOfBlock]);
+		}
+	};
+
+	// Hash chains over the window before the current position, positions are
+	// kept relative to the start of the dictionary plus one so 0 is empty
+	class MatchFinder
+	{
+	private:
+		const std::uint8_t* m_data;
+		std::size_t m_base;
+		std::size_t m_end;
+		std::vector<std::uint32_t> m_heads;
+		std::vector<std::uint32_t> m_previous;
+	public:
+		MatchFinder(const std::uint8_t* data, std::size_t base, std::size_t end)
+			: m_data(data),
+			m_base(base),
+			m_end(end),
+			m_heads(std::size_t{ 1 } << HashBits, 0),
+			m_previous(Deflate::WindowSize, 0)
+		{
+
+		}
+
+		void insert(std::size_t position)
+		{
+			if (position + MinimumMatch > m_end) {
+				return;
+			}
+			const std::uint32_t hash = getHash(position);
+			m_previous[position & WindowMask] = m_heads[hash];
+			m_heads[hash] = static_cast<std::uint32_t>(position - m_base + 1);
+		}
+
+		// Longest match for position among at most chain earlier positions
+		std::size_t find(std::size_t position, std::size_t chain, std::size_t nice, std::size_t& distance) const
+		{
+			const std::size_t limit = std::min(MaximumMatch, m_end - position);
+			if (limit < MinimumMatch) {
+				return 0;
+			}
+
+			std::size_t best = MinimumMatch - 1;
+			std::uint32_t candidate = m_heads[getHash(position)];
+			const std::uint8_t* current = m_data + position;
+			while (candidate != 0 && chain-- != 0) {
+				const std::size_t earlier = m_base + candidate - 1;
+				if (position - earlier > Deflate::WindowSize) {
+					break;
+				}
+
+				const std::uint8_t* match = m_data + earlier;
+				if (match[best] == current[best] && match[0] == current[0]) {
+					std::size_t length = 0;
+					while (length != limit && match[length] == current[length]) {
+						++length;
+					}
+					if (length > best) {
+						best = length;
+						distance = position - earlier;
+						if (length >= nice || length == limit) {
+							break;
+						}
+					}
+				}
+
+				// Slots are reused once the window moves on, a chain never
+				// leads to a later position
+				const std::uint32_t next = m_previous[earlier & WindowMask];
+				if (next >= candidate) {
+					break;
+				}
+				candidate = next;
+			}
+			return best >= MinimumMatch ? best : 0;
+		}
+
+	private:
+		std::uint32_t getHash(std::size_t position) const
+		{
+			const std::uint32_t value = m_data[position] | (m_data[position + 1] << 8) | (m_data[position + 2] << 16);
+			return (value * 2654435761u) >> (32 - HashBits);
+		}
+	};
+}
+
+void Deflate::compress(const std::uint8_t* data, std::size_t begin, std::size_t end, int level, bool last, std::vector<std::uint8_t>& output)
+{
+	level = std::clamp(level, 0, MaximumLevel);
+	BlockEncoder encoder(data, begin, output);
+
+	if (level == 0) {
+		BlockEncoder::writeStored(data + begin, end - begin, last, encoder.getWriter());
+		return;
+	}
+
+	// The window before the range is only indexed, never written
+	const std::size_t dictionary = begin - std::min(begin, WindowSize);
+	MatchFinder finder(data, dictionary, end);
+	for (std::size_t position = dictionary; position != begin; ++position) {
+		finder.insert(position);
+	}
+
+	const LevelParameters parameters = levels[level];
+	bool finished = false;
+	std::size_t position = begin;
+	if (level < LazyLevel) {
+		while (position != end) {
+			std::size_t distance = 0;
+			const std::size_t length = finder.find(position, parameters.chain, parameters.nice, distance);
+			finder.insert(position);
+
+			if (length) {
+				encoder.addMatch(length, distance);
+				if (length <= parameters.lazy) {
+					for (std::size_t index = 1; index != length; ++index) {
+						finder.insert(position + index);
+					}
+				}
+				position += length;
+			}
+			else {
+				encoder.addLiteral(data[position]);
+				++position;
+			}
+
+			if (encoder.isFull()) {
+				finished = last && position == end;
+				encoder.flush(position, finished);
+			}
+		}
+	}
+	else {
+		// A match found at the previous position is only taken when the one
+		// at this position isn't longer, otherwise the previous byte becomes
+		// a literal. Until then it is pending and not yet encoded.
+		std::size_t previousLength = 0;
+		std::size_t previousDistance = 0;
+		bool pending = false;
+		while (position != end) {
+			std::size_t distance = 0;
+			std::size_t length = 0;
+			if (previousLength < parameters.lazy) {
+				const std::size_t chain = previousLength >= parameters.good ? parameters.chain >> 2 : parameters.chain;
+				length = finder.find(position, chain, parameters.nice, distance);
+				if (length == MinimumMatch && distance > TooFar) {
+					length = 0;
+				}
+			}
+			finder.insert(position);
+
+			std::size_t encoded = position;
+			if (previousLength && length <= previousLength) {
+				// Every position inside the match stays in the chains
+				const std::size_t matchEnd = position - 1 + previousLength;
+				for (std::size_t index = position + 1; index != matchEnd; ++index) {
+					finder.insert(index);
+				}
+				encoder.addMatch(previousLength, previousDistance);
+				position = matchEnd;
+				encoded = position;
+				previousLength = 0;
+				pending = false;
+			}
+			else {
+				if (pending) {
+					encoder.addLiteral(data[position - 1]);
+				}
+				previousLength = length;
+				previousDistance = distance;
+				pending = true;
+				++position;
+				encoded = position - 1;
+			}
+
+			if (encoder.isFull()) {
+				finished = last && encoded == end;
+				encoder.flush(encoded, finished);
+			}
+		}
+		if (pending) {
+			encoder.addLiteral(data[end - 1]);
+		}
+	}
+
+	if (!finished && (!encoder.isEmpty() || last)) {
+		encoder.flush(end, last);
+	}
+	if (!last) {
+		// Empty stored block, ends the range on a byte boundary
+		BlockEncoder::writeStored(nullptr, 0, false, encoder.getWriter());
+	}
+	encoder.getWriter().align();
+}
+
+std::uint32_t Deflate::adler32(const std::uint8_t* data, std::size_t size, std::uint32_t adler)
+{
+	// Largest run of bytes whose sums can't overflow 32 bits
+	constexpr std::size_t Run = 5552;
+	constexpr std::uint32_t Modulo = 65521;
+
+	std::uint32_t low = adler & 0xFFFF;
+	std::uint32_t high = adler >> 16;
+	while (size != 0) {
+		const std::size_t run = std::min(size, Run);
+		for (std::size_t index = 0; index != run; ++index) {
+			low += data[index];
+			high += low;
+		}
+		low %= Modulo;
+		high %= Modulo;
+		data += run;
+		size -= run;
+	}
+	return (high << 16) | low;
+}
+
+std::uint32_t Deflate::combineAdler32(std::uint32_t first, std::uint32_t second, std::size_t length)
+{
+	constexpr std::uint64_t Modulo = 65521;
+
+	const std::uint64_t remainder = length % Modulo;
+	const std::uint64_t firstLow = first & 0xFFFF;
+	const std::uint64_t low = (firstLow + (second & 0xFFFF) + Modulo - 1) % Modulo;
+	const std::uint64_t high = (remainder * firstLow + (first >> 16) + (second >> 16) + Modulo - remainder) % Modulo;
+	return static_cast<std::uint32_t>((high << 16) | low);
+}
@@ -0,0 +1,102 @@
+#include "GlyphCache.h"
+#include <limits>
+#include <map>
+#include <memory>
+#include <tuple>
+
+namespace
+{
+	using TableKey = std::tuple<const sf::Font*, sf::Uint32, bool, float>;
+
+	std::mutex tablesMutex;
+	std::map<TableKey, std::unique_ptr<GlyphTable>> tables;
+}
+
+GlyphTable::GlyphTable(const sf::Font& font, sf::Uint32 characterSize, bool bold, float outlineThickness)
+	: m_font(&font),
+	m_characterSize(characterSize),
+	m_bold(bold),
+	m_outlineThickness(outlineThickness),
+	m_lineSpacing(font.getLineSpacing(characterSize)),
+	m_underlinePosition(font.getUnderlinePosition(characterSize)),
+	m_underlineThickness(font.getUnderlineThickness(characterSize)),
+	m_spaceAdvance(font.getGlyph(L' ', characterSize, bold).advance),
+	m_xBounds(font.getGlyph(L'x', characterSize, bold).bounds),
+	m_glyphCount(2)
+{
+	for (auto& loaded : m_loaded) {
+		loaded.store(false, std::memory_order_relaxed);
+	}
+	for (auto& kerning : m_kernings) {
+		kerning.store(std::numeric_limits<float>::quiet_NaN(), std::memory_order_relaxed);
+	}
+}
+
+void GlyphTable::loadGlyph(std::size_t index) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_loaded[index].load(std::memory_order_relaxed)) {
+		return;
+	}
+	m_glyphs[index] = m_font->getGlyph(FirstCharacter + static_cast<sf::Uint32>(index), m_characterSize, m_bold, m_outlineThickness);
+	++m_glyphCount;
+	m_loaded[index].store(true, std::memory_order_release);
+}
+
+float GlyphTable::getLineSpacing() const
+{
+	return m_lineSpacing;
+}
+
+float GlyphTable::getUnderlinePosition() const
+{
+	return m_underlinePosition;
+}
+
+float GlyphTable::getUnderlineThickness() const
+{
+	return m_underlineThickness;
+}
+
+float GlyphTable::getSpaceAdvance() const
+{
+	return m_spaceAdvance;
+}
+
+sf::FloatRect GlyphTable::getXBounds() const
+{
+	return m_xBounds;
+}
+
+std::size_t GlyphTable::getGlyphCount() const
+{
+	return m_glyphCount;
+}
+
+const GlyphTable& GlyphCache::get(const sf::Font& font, sf::Uint32 characterSize, bool bold, float outlineThickness)
+{
+	std::lock_guard<std::mutex> lock(tablesMutex);
+	auto& table = tables[TableKey{ &font, characterSize, bold, outlineThickness }];
+	if (!table) {
+		table = std::make_unique<GlyphTable>(font, characterSize, bold, outlineThickness);
+	}
+	return *table;
+}
+
+void GlyphCache::clear()
+{
+	std::lock_guard<std::mutex> lock(tablesMutex);
+	tables.clear();
+}
+
+std::size_t GlyphCache::getGlyphCount(const sf::Font& font, sf::Uint32 characterSize)
+{
+	std::lock_guard<std::mutex> lock(tablesMutex);
+	std::size_t count = 0;
+	for (auto& [key, table] : tables) {
+		if (std::get<0>(key) == &font && std::get<1>(key) == characterSize) {
+			count += table->getGlyphCount();
+		}
+	}
+	return count;
+}
@@ -1,42 +1,56 @@
 #include "Highlighter.h"
 #include <fstream>
+#include <algorithm>
 #include <cctype>
+#include <stdexcept>
 #include "Utilities.h"
+#include "KeywordHash.h"
 
 namespace
 {
-	bool isEscaped(const std::string& string, std::size_t boundary, std::size_t index) {
-		bool escaped = false;
-		while (index > boundary && string[--index] == '\\') {
-			escaped = !escaped;
+	const Detail plainDetail(&Detail::any, sf::Color(0, 0, 0), sf::Text::Style::Regular);
+	const Detail commentDetail(sf::Color(5, 115, 11), &Detail::any);
+	const Detail macroDetail(sf::Color(128, 128, 128), &Detail::any);
+	const Detail includeDetail(sf::Color(137, 16, 8), &Detail::any);
+	const Detail quoteDetail(sf::Color(187, 41, 21), &Detail::any);
+
+	// Indexed by KeywordGroup
+	const Detail groupDetails[] = {
+		{ sf::Color(0, 0, 255), &Detail::fundamentalType },
+		{ { 32, 100, 148 }, &Detail::userType },
+		{ { 80, 170, 192 }, &Detail::any }
+	};
+
+	bool isIdentifierKey(std::string_view key)
+	{
+		for (char ch : key) {
+			if (!Lexer::isIdentifier(ch)) {
+				return false;
+			}
 		}
-		return escaped;
+		return !key.empty();
 	}
 }
 
-Highlighter::Highlighter()
+Highlighter::Highlighter(std::pmr::memory_resource* resource)
+	: m_font(nullptr),
+	m_characterSize(0),
+	m_needsUpdate(true),
+	m_tokens(resource),
+	m_marks(resource)
 {
-	std::ifstream file("keywords.txt", std::ifstream::in);
-
-	std::string keyword;
-	while (std::getline(file, keyword)) {
-		addKeyword(keyword, { sf::Color::Blue, &Detail::fundamentalType });
-	}
-
-	std::string stdtype;
-	file.close();
-	file.clear();
-	file.open("stdtypes.txt", std::ifstream::in);
-	while (std::getline(file, stdtype)) {
-		addKeyword(stdtype, { {32, 100, 148}, &Detail::userType });
-	}
+}
 
-	file.close();
-	file.clear();
-	file.open("operators.txt", std::ifstream::in);
-	while (std::getline(file, keyword)) {
-		addKeyword(keyword, { {80, 170, 192}, &Detail::any });
-	}
+Highlighter::Highlighter(const Highlighter& highlighter, std::pmr::memory_resource* resource)
+	: m_font(highlighter.m_font),
+	m_characterSize(highlighter.m_characterSize),
+	m_overrides(highlighter.m_overrides),
+	m_needsUpdate(highlighter.m_needsUpdate),
+	m_matcher(highlighter.m_matcher),
+	m_matcherDetails(highlighter.m_matcherDetails),
+	m_tokens(resource),
+	m_marks(resource)
+{
 }
 
 void Highlighter::setFont(const sf::Font& font)
@@ -54,137 +68,179 @@ const sf::Font& Highlighter::getFont() const
 	return *m_font;
 }
 
+bool Highlighter::loadKeywords(const std::string& filePath, KeywordGroup group)
+{
+	std::ifstream file(filePath, std::ifstream::in);
+	if (!file) {
+		return false;
+	}
+
+	const Detail detail = getGroupDetail(group);
+	std::string keyword;
+	while (std::getline(file, keyword)) {
+		if (!keyword.empty()) {
+			addKeyword(keyword, detail);
+		}
+	}
+	return true;
+}
+
 void Highlighter::addKeyword(const std::string& key, Detail detail)
 {
-	m_keywords.emplace(key, detail);
+	m_overrides.insert_or_assign(key, detail);
+	m_needsUpdate = true;
 }
 
 bool Highlighter::removeKeyword(const std::string& key)
 {
-	auto it = m_keywords.find(key);
-
-	if (it != m_keywords.end()) {
-		m_keywords.erase(it);
+	if (!findKeyword(key)) {
+		return false;
 	}
-	return it != m_keywords.end();
+	m_overrides.insert_or_assign(key, std::nullopt);
+	m_needsUpdate = true;
+	return true;
 }
 
 Detail Highlighter::getKeyword(const std::string& key) const
 {
-	return m_keywords.at(key);
+	const Detail* detail = findKeyword(key);
+	if (!detail) {
+		throw std::out_of_range("Highlighter::getKeyword: unknown keyword");
+	}
+	return *detail;
 }
 
-SmartText Highlighter::buildText(const std::string& line) const
+const Detail* Highlighter::findKeyword(std::string_view key) const
 {
-	SmartText text(line, *m_font);
-	text.setCharacterSize(m_characterSize);
-	text.setFillColor(sf::Color::Black);
-	text.setStyle(sf::Text::Style::Regular);
-	highlightKeywords(text);
-	highlightMacros(text);
-	highlightQuotes(text);
-	highlightComments(text);
+	if (!m_overrides.empty()) {
+		auto keyword = m_overrides.find(key);
+		if (keyword != m_overrides.end()) {
+			return keyword->second ? &*keyword->second : nullptr;
+		}
+	}
 
-	return text;
+	const BuiltinKeyword* builtin = KeywordHash::getBuiltin().find(key);
+	return builtin ? &groupDetails[static_cast<std::size_t>(builtin->group)] : nullptr;
 }
 
-void Highlighter::highlightComments(SmartText& text) const
+Detail Highlighter::getGroupDetail(KeywordGroup group)
 {
-	std::string line = text.getString();
-	std::size_t comment = std::string::npos;
-
-	const sf::Color commentColor(5, 115, 11);
-	while ((comment = line.find("//", comment + 1)) != std::string::npos) {
-		std::size_t opening = std::string::npos;
-
-		for (std::size_t index = 0; index != line.size(); ++index) {
-			if (line[index] != '\"') {
-				continue;
-			}
+	return groupDetails[static_cast<std::size_t>(group)];
+}
 
-			if (opening == std::string::npos) {
-				opening = index;
-			}
-			else if (!isEscaped(line, opening, index)) {
-				if (comment >= opening && comment < index) {
-					return;
-				}
-			}
+void Highlighter::ensureMatcherUpdate() const
+{
+	if (!m_needsUpdate) {
+		return;
+	}
+	m_needsUpdate = false;
+
+	// Identifiers are looked up whole, only operators and other symbol keys
+	// are compiled into the automaton. The details are kept in pattern order
+	// so a match can be resolved without hashing the keyword.
+	m_matcher.clear();
+	m_matcherDetails.clear();
+	for (auto& keyword : KeywordTables::entries) {
+		if (!isIdentifierKey(keyword.key) && m_overrides.find(keyword.key) == m_overrides.end()) {
+			m_matcher.addPattern(keyword.key);
+			m_matcherDetails.push_back(getGroupDetail(keyword.group));
 		}
-		text.setFillColor(comment, commentColor);
 	}
+	for (auto& keyword : m_overrides) {
+		if (keyword.second && !isIdentifierKey(keyword.first)) {
+			m_matcher.addPattern(keyword.first);
+			m_matcherDetails.push_back(*keyword.second);
+		}
+	}
+	m_matcher.compile();
 }
 
-void Highlighter::highlightKeywords(SmartText& text) const
+void Highlighter::highlight(std::string_view line, std::vector<HighlightSpan>& spans) const
 {
-	std::string line = text.getString();
-
-	const auto begin = line.begin();
-	const auto end = line.end();
+	ensureMatcherUpdate();
+	spans.clear();
 
-	const auto validInstance = [](char ch) -> bool {
-		return !std::isalnum(ch) && ch != '_' && ch != ':';
-	};
+	Lexer::tokenize(line, m_tokens);
 
-	for (auto& keyword : m_keywords) {
-		auto key = keyword.first;
-		auto iter = begin; 
-		while ((iter = std::search(iter, end, key.begin(), key.end())) != end) {
-			const std::size_t index = iter - line.begin();
-			const bool before = index == 0 || keyword.second.validate(*std::prev(iter));
-			const bool after = index + key.size() == line.size() || keyword.second.validate(*(iter + key.size()));
-			if (before && after) {
-				text.setFillColor(index, key.size(), keyword.second.color);
-				text.setStyle(index, key.size(), keyword.second.style);
-			}
-			std::advance(iter, key.size());
+	auto append = [&](std::size_t start, std::size_t length, const Detail& detail) {
+		if (!spans.empty() && spans.back().color == detail.color && spans.back().style == detail.style) {
+			spans.back().length += length;
 		}
-	}
-}
+		else {
+			spans.push_back({ start, length, detail.color, detail.style });
+		}
+	};
 
-void Highlighter::highlightMacros(SmartText& text) const
-{
-	std::string line = text.getString();
+	auto validate = [&](const Detail& detail, std::size_t start, std::size_t length) {
+		const bool before = start == 0 || detail.validate(line[start - 1]);
+		const bool after = start + length == line.size() || detail.validate(line[start + length]);
+		return before && after;
+	};
 
-	for (auto ch : line) {
-		if (ch == '#') {
-			text.setFillColor({ 128, 128, 128 });
+	for (auto& token : m_tokens) {
+		switch (token.kind)
+		{
+		case Lexer::Kind::Comment:
+			append(token.start, token.length, commentDetail);
+			break;
+		case Lexer::Kind::String:
+		case Lexer::Kind::Character:
+			append(token.start, token.length, quoteDetail);
+			break;
+		case Lexer::Kind::Preprocessor:
+			append(token.start, token.length, macroDetail);
+			break;
+		case Lexer::Kind::IncludePath:
+			append(token.start, token.length, includeDetail);
+			break;
+		case Lexer::Kind::Identifier: {
+			const Detail* keyword = findKeyword(line.substr(token.start, token.length));
+			const bool valid = keyword && validate(*keyword, token.start, token.length);
+			append(token.start, token.length, valid ? *keyword : plainDetail);
 			break;
 		}
-		else if (!std::isspace(ch)) {
-			return;
+		case Lexer::Kind::Operator: {
+			// Operators overlap ("<<=" holds "<<" and "<"), later matches win
+			m_marks.assign(token.length, &plainDetail);
+			m_matcher.scan(line.substr(token.start, token.length), [&](const KeywordMatcher::Match& match) {
+				const Detail& detail = m_matcherDetails[match.pattern];
+				if (validate(detail, token.start + match.index, match.length)) {
+					std::fill_n(m_marks.begin() + match.index, match.length, &detail);
+				}
+			});
+			for (std::size_t index = 0; index != token.length; ++index) {
+				append(token.start + index, 1, *m_marks[index]);
+			}
+			break;
+		}
+		default:
+			append(token.start, token.length, plainDetail);
+			break;
 		}
 	}
+}
 
-	std::size_t start = std::string::npos;
-	std::size_t end = std::string::npos;
-	while ((start = line.find('<', start + 1)) != std::string::npos && (end = line.find('>', start + 1)) != std::string::npos) {
-		const sf::Color color(137, 16, 8);
-		text.setFillColor(start, end - start + 1, { color });
-		start = end;
+void Highlighter::appendSpans(const std::vector<HighlightSpan>& spans, std::size_t offset, std::pmr::vector<SmartText::Span>& chunks)
+{
+	for (auto& span : spans) {
+		SmartText::ChunkData data(span.length);
+		data.fill(span.color).stylize(span.style);
+		chunks.push_back({ offset + span.start, std::move(data) });
 	}
 }
 
-void Highlighter::highlightQuotes(SmartText& text) const
+SmartText Highlighter::buildText(const std::string& line) const
 {
-	std::string line = text.getString();
+	std::vector<HighlightSpan> spans;
+	highlight(line, spans);
 
-	std::size_t start = std::string::npos; 
-	std::size_t end   = std::string::npos;
+	std::pmr::vector<SmartText::Span> chunks;
+	chunks.reserve(spans.size());
+	appendSpans(spans, 0, chunks);
 
-	while ((start = line.find_first_of("\"\'", start + 1)) != std::string::npos) {
-		const std::size_t marking = start;
-
-		while ((end = line.find_first_of("\"\'", start + 1)) != std::string::npos) {
-			const bool escaped = isEscaped(line, start, end);
-			start = end;
+	SmartText text(line, *m_font);
+	text.setCharacterSize(m_characterSize);
+	text.applySpans(chunks);
 
-			if (!escaped) {
-				const sf::Color color(187, 41, 21);
-				text.setFillColor(marking, end - marking + 1, { color });
-				break;
-			}
-		}
-	}
+	return text;
 }
-
@@ -0,0 +1,78 @@
+#include "KeywordHash.h"
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+
+KeywordHash::KeywordHash(const BuiltinKeyword* entries, std::size_t count)
+	: m_seeds(std::max<std::size_t>(1, count / 2), 0),
+	m_slots(std::max<std::size_t>(1, count), nullptr),
+	m_lengths(0),
+	m_firstCharacters{}
+{
+	std::vector<std::uint32_t> hashes(count);
+	std::vector<std::vector<std::size_t>> buckets(m_seeds.size());
+	for (std::size_t index = 0; index != count; ++index) {
+		const std::string_view key = entries[index].key;
+		if (key.empty() || key.size() >= 64) {
+			throw std::invalid_argument("KeywordHash: keys must be 1 to 63 characters long");
+		}
+		m_lengths |= std::uint64_t{ 1 } << key.size();
+		const unsigned char first = static_cast<unsigned char>(key[0]);
+		m_firstCharacters[first >> 6] |= std::uint64_t{ 1 } << (first & 63u);
+
+		hashes[index] = hash(key);
+		buckets[hashes[index] % buckets.size()].push_back(index);
+	}
+
+	// Hash and displace: the largest buckets are placed first while most
+	// slots are still free, each bucket searches for a seed that moves all
+	// of its keys onto free and distinct slots.
+	std::vector<std::size_t> order(buckets.size());
+	std::iota(order.begin(), order.end(), std::size_t{ 0 });
+	std::stable_sort(order.begin(), order.end(), [&buckets](std::size_t left, std::size_t right) {
+		return buckets[left].size() > buckets[right].size();
+	});
+
+	std::vector<std::size_t> slots;
+	for (std::size_t bucket : order) {
+		if (buckets[bucket].empty()) {
+			break;
+		}
+
+		for (std::uint32_t seed = 1; ; ++seed) {
+			if (seed == 0) {
+				throw std::logic_error("KeywordHash: keys with equal hashes can't be separated");
+			}
+
+			slots.clear();
+			bool placed = true;
+			for (std::size_t index : buckets[bucket]) {
+				const std::size_t slot = place(hashes[index], seed) % m_slots.size();
+				if (m_slots[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+					placed = false;
+					break;
+				}
+				slots.push_back(slot);
+			}
+
+			if (placed) {
+				m_seeds[bucket] = seed;
+				for (std::size_t index = 0; index != slots.size(); ++index) {
+					m_slots[slots[index]] = &entries[buckets[bucket][index]];
+				}
+				break;
+			}
+		}
+	}
+
+	// Unused slots of an empty table still compare against a key
+	static const BuiltinKeyword none{ {}, KeywordGroup::Keyword };
+	std::replace(m_slots.begin(), m_slots.end(), static_cast<const BuiltinKeyword*>(nullptr), &none);
+}
+
+const KeywordHash& KeywordHash::getBuiltin()
+{
+	static const KeywordHash builtin(KeywordTables::entries, std::size(KeywordTables::entries));
+	return builtin;
+}
@@ -0,0 +1,99 @@
+#include "KeywordMatcher.h"
+#include <queue>
+
+
+KeywordMatcher::KeywordMatcher()
+	: m_classCount(1)
+{
+	m_classes.fill(0);
+}
+
+void KeywordMatcher::clear()
+{
+	m_patterns.clear();
+	m_nodes.clear();
+	m_transitions.clear();
+	m_classes.fill(0);
+	m_classCount = 1;
+}
+
+std::size_t KeywordMatcher::addPattern(std::string_view pattern)
+{
+	m_patterns.emplace_back(pattern);
+	return m_patterns.size() - 1;
+}
+
+void KeywordMatcher::compile()
+{
+	m_nodes.clear();
+	m_transitions.clear();
+	m_classes.fill(0);
+	m_classCount = 1;
+
+	// Only characters used by a pattern get their own column, every other
+	// character shares column 0 which always leads back to the root.
+	for (const auto& pattern : m_patterns) {
+		for (unsigned char ch : pattern) {
+			if (m_classes[ch] == 0) {
+				m_classes[ch] = static_cast<std::uint8_t>(m_classCount++);
+			}
+		}
+	}
+
+	// Build the trie, missing edges are marked with -1
+	m_nodes.push_back({ 0, 0, -1 });
+	m_transitions.assign(m_classCount, -1);
+	for (std::size_t pattern = 0; pattern != m_patterns.size(); ++pattern) {
+		if (m_patterns[pattern].empty()) {
+			continue;
+		}
+
+		State state = 0;
+		for (unsigned char ch : m_patterns[pattern]) {
+			State& edge = m_transitions[static_cast<std::size_t>(state) * m_classCount + m_classes[ch]];
+			if (edge < 0) {
+				edge = static_cast<State>(m_nodes.size());
+				m_nodes.push_back({ 0, 0, -1 });
+				m_transitions.resize(m_transitions.size() + m_classCount, -1);
+			}
+			state = m_transitions[static_cast<std::size_t>(state) * m_classCount + m_classes[ch]];
+		}
+		if (m_nodes[state].pattern < 0) {
+			m_nodes[state].pattern = static_cast<std::int32_t>(pattern);
+		}
+	}
+
+	// Breadth first pass computing failure links and turning the trie into a
+	// complete automaton so scanning is a single table lookup per character.
+	std::queue<State> pending;
+	for (std::size_t column = 0; column != m_classCount; ++column) {
+		State& edge = m_transitions[column];
+		if (edge < 0) {
+			edge = 0;
+		}
+		else {
+			m_nodes[edge].failure = 0;
+			pending.push(edge);
+		}
+	}
+
+	while (!pending.empty()) {
+		const State state = pending.front();
+		pending.pop();
+
+		const State failure = m_nodes[state].failure;
+		m_nodes[state].output = m_nodes[failure].pattern >= 0 ? failure : m_nodes[failure].output;
+
+		for (std::size_t column = 0; column != m_classCount; ++column) {
+			State& edge = m_transitions[static_cast<std::size_t>(state) * m_classCount + column];
+			const State fallback = m_transitions[static_cast<std::size_t>(failure) * m_classCount + column];
+			if (edge < 0) {
+				edge = fallback;
+			}
+			else {
+				m_nodes[edge].failure = fallback;
+				pending.push(edge);
+			}
+		}
+	}
+}
@@ -0,0 +1,140 @@
+#include "Lexer.h"
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+	bool isSpace(char ch)
+	{
+		return std::isspace(static_cast<unsigned char>(ch)) != 0;
+	}
+
+	bool isDigit(char ch)
+	{
+		return std::isdigit(static_cast<unsigned char>(ch)) != 0;
+	}
+
+	// Index one past the closing quote, escaped quotes do not close the literal
+	std::size_t skipLiteral(std::string_view line, std::size_t start)
+	{
+		const char quote = line[start];
+		std::size_t index = start + 1;
+		while (index < line.size()) {
+			if (line[index] == '\\') {
+				index += 2;
+			}
+			else if (line[index++] == quote) {
+				return index;
+			}
+		}
+		return line.size();
+	}
+
+	bool isCommentStart(std::string_view line, std::size_t index)
+	{
+		return line[index] == '/' && index + 1 != line.size() && (line[index + 1] == '/' || line[index + 1] == '*');
+	}
+}
+
+bool Lexer::isIdentifier(char ch)
+{
+	return std::isalnum(static_cast<unsigned char>(ch)) || ch == '_' || static_cast<unsigned char>(ch) >= 0x80;
+}
+
+bool Lexer::isOperator(char ch)
+{
+	return ch != '\0' && std::strchr("+-*/%<>=!&|^~?:.", ch) != nullptr;
+}
+
+void Lexer::tokenize(std::string_view line, std::pmr::vector<Token>& tokens)
+{
+	tokens.clear();
+
+	const std::size_t size = line.size();
+	std::size_t index = 0;
+
+	auto push = [&](Kind kind, std::size_t start) {
+		// Directive text is split around literals and comments only
+		if (kind == Kind::Preprocessor && !tokens.empty() && tokens.back().kind == kind) {
+			tokens.back().length += index - start;
+		}
+		else {
+			tokens.push_back({ kind, start, index - start });
+		}
+	};
+
+	while (index != size && isSpace(line[index])) {
+		++index;
+	}
+	if (index != 0) {
+		push(Kind::Whitespace, 0);
+	}
+
+	const bool preprocessor = index != size && line[index] == '#';
+	// Position of the '>' closing the next include path, npos once none is left
+	std::size_t closing = 0;
+
+	while (index != size) {
+		const std::size_t start = index;
+		const char ch = line[index];
+
+		if (isCommentStart(line, index)) {
+			if (line[index + 1] == '/') {
+				index = size;
+			}
+			else {
+				const std::size_t end = line.find("*/", index + 2);
+				index = end != std::string_view::npos ? end + 2 : size;
+			}
+			push(Kind::Comment, start);
+		}
+		else if (ch == '"' || ch == '\'') {
+			index = skipLiteral(line, index);
+			push(ch == '"' ? Kind::String : Kind::Character, start);
+		}
+		else if (preprocessor) {
+			if (ch == '<' && closing != std::string_view::npos) {
+				if (closing <= index) {
+					closing = line.find('>', index + 1);
+				}
+				if (closing != std::string_view::npos) {
+					index = closing + 1;
+					push(Kind::IncludePath, start);
+					continue;
+				}
+			}
+			++index;
+			push(Kind::Preprocessor, start);
+		}
+		else if (isSpace(ch)) {
+			while (index != size && isSpace(line[index])) {
+				++index;
+			}
+			push(Kind::Whitespace, start);
+		}
+		else if (isDigit(ch)) {
+			// Digit separators are only taken when another digit follows
+			while (index != size && (isIdentifier(line[index]) || line[index] == '.' ||
+				(line[index] == '\'' && index + 1 != size && isIdentifier(line[index + 1])))) {
+				++index;
+			}
+			push(Kind::Number, start);
+		}
+		else if (isIdentifier(ch)) {
+			while (index != size && isIdentifier(line[index])) {
+				++index;
+			}
+			push(Kind::Identifier, start);
+		}
+		else if (isOperator(ch)) {
+			do {
+				++index;
+			} while (index != size && isOperator(line[index]) && !isCommentStart(line, index));
+			push(Kind::Operator, start);
+		}
+		else {
+			++index;
+			push(Kind::Punctuation, start);
+		}
+	}
+}
@@ -0,0 +1,46 @@
+#include "LineCache.h"
+
+
+const LineCache::Spans* LineCache::find(std::string_view line) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto entry = m_lines.find(line);
+	return entry != m_lines.end() ? &entry->second->spans : nullptr;
+}
+
+const LineCache::Spans& LineCache::insert(std::string_view line, Spans spans)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto entry = m_lines.find(line);
+	if (entry == m_lines.end()) {
+		auto owned = std::make_unique<Entry>(Entry{ std::string(line), std::move(spans) });
+		const std::string_view key = owned->line;
+		entry = m_lines.emplace(key, std::move(owned)).first;
+	}
+	return entry->second->spans;
+}
+
+const LineCache::Vertices* LineCache::findGeometry(std::string_view line, const sf::Font& font, unsigned characterSize) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto entry = m_lines.find(line);
+	if (entry == m_lines.end()) {
+		return nullptr;
+	}
+	auto geometry = entry->second->geometry.find({ &font, characterSize });
+	return geometry != entry->second->geometry.end() ? &geometry->second : nullptr;
+}
+
+const LineCache::Vertices& LineCache::insertGeometry(std::string_view line, const sf::Font& font, unsigned characterSize, Vertices vertices)
+{
+	// Another worker may have drawn the line meanwhile, the first one is kept
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto& geometry = m_lines.at(line)->geometry;
+	return geometry.emplace(GeometryKey{ &font, characterSize }, std::move(vertices)).first->second;
+}
+
+void LineCache::clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_lines.clear();
+}
@@ -0,0 +1,58 @@
+#include "LineSplitter.h"
+#include <cstring>
+#include <string>
+#include "CharClass.h"
+
+LineSplitter::LineSplitter(std::string_view data, bool stripIndent)
+	: m_data(data),
+	m_position(0),
+	m_lineNumber(0),
+	m_markStart(std::string::npos),
+	m_stripIndent(stripIndent)
+{
+}
+
+bool LineSplitter::next(Line& line)
+{
+	if (m_position >= m_data.size()) {
+		return false;
+	}
+
+	// Markers and indentation are stripped by moving the bounds of the view
+	// rather than copying the line.
+	const char* newline = static_cast<const char*>(std::memchr(m_data.data() + m_position, '\n', m_data.size() - m_position));
+	const std::size_t next = newline ? static_cast<std::size_t>(newline - m_data.data()) : m_data.size();
+	std::string_view text = m_data.substr(m_position, next - m_position);
+	m_position = next + 1;
+
+	line.fixedStart = 0;
+	line.fixedEnd = 0;
+	if (!text.empty() && text.back() == '\r') {
+		text.remove_suffix(1);
+	}
+	if (text.size() >= 2 && text[0] == '~' && text[1] == '>') {
+		m_markStart = m_lineNumber;
+		text.remove_prefix(2);
+	}
+	if (text.size() >= 2 && text[text.size() - 2] == '<' && text[text.size() - 1] == '~') {
+		line.fixedStart = m_markStart != std::string::npos ? m_markStart : m_lineNumber;
+		line.fixedEnd = m_lineNumber + 1;
+		text.remove_suffix(2);
+		m_markStart = std::string::npos;
+	}
+
+	line.kept = CharClass::skipWhitespace(text.data(), text.size()) != text.size();
+	if (line.kept) {
+		if (m_stripIndent) {
+			text.remove_prefix(CharClass::blankRun(text.data(), text.size()).length);
+		}
+		++m_lineNumber;
+	}
+	line.text = text;
+	return true;
+}
+
+std::size_t LineSplitter::getLineCount() const
+{
+	return m_lineNumber;
+}
@@ -0,0 +1,173 @@
+#include "MappedFile.h"
+#include <utility>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::MappedFile()
+	: m_data(nullptr),
+	m_size(0),
+#ifdef _WIN32
+	m_file(INVALID_HANDLE_VALUE),
+	m_mapping(nullptr)
+#else
+	m_descriptor(-1)
+#endif
+{
+}
+
+MappedFile::MappedFile(const std::string& filePath)
+	: MappedFile()
+{
+	open(filePath);
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+MappedFile::MappedFile(MappedFile&& file) noexcept
+	: MappedFile()
+{
+	swap(file);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& file) noexcept
+{
+	if (this != &file) {
+		close();
+		swap(file);
+	}
+	return *this;
+}
+
+bool MappedFile::open(const std::string& filePath)
+{
+	close();
+#ifdef _WIN32
+	m_file = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_file, &size)) {
+		close();
+		return false;
+	}
+	m_size = static_cast<std::size_t>(size.QuadPart);
+	if (m_size == 0) {
+		return true;
+	}
+
+	m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!m_mapping) {
+		close();
+		return false;
+	}
+	m_data = static_cast<const char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	m_descriptor = ::open(filePath.c_str(), O_RDONLY);
+	if (m_descriptor < 0) {
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(m_descriptor, &status) != 0) {
+		close();
+		return false;
+	}
+	m_size = static_cast<std::size_t>(status.st_size);
+	if (m_size == 0) {
+		return true;
+	}
+
+	void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_descriptor, 0);
+	if (data != MAP_FAILED) {
+		madvise(data, m_size, MADV_SEQUENTIAL);
+		m_data = static_cast<const char*>(data);
+	}
+#endif
+	if (!m_data) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping) {
+		CloseHandle(m_mapping);
+	}
+	if (m_file != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_file);
+	}
+	m_file = INVALID_HANDLE_VALUE;
+	m_mapping = nullptr;
+#else
+	if (m_data) {
+		munmap(const_cast<char*>(m_data), m_size);
+	}
+	if (m_descriptor >= 0) {
+		::close(m_descriptor);
+	}
+	m_descriptor = -1;
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
+
+bool MappedFile::isOpen() const
+{
+#ifdef _WIN32
+	return m_file != INVALID_HANDLE_VALUE;
+#else
+	return m_descriptor >= 0;
+#endif
+}
+
+const char* MappedFile::getData() const
+{
+	return m_data;
+}
+
+std::size_t MappedFile::getSize() const
+{
+	return m_size;
+}
+
+std::string_view MappedFile::getView() const
+{
+	return { m_data, m_size };
+}
+
+void MappedFile::swap(MappedFile& file) noexcept
+{
+	std::swap(m_data, file.m_data);
+	std::swap(m_size, file.m_size);
+#ifdef _WIN32
+	std::swap(m_file, file.m_file);
+	std::swap(m_mapping, file.m_mapping);
+#else
+	std::swap(m_descriptor, file.m_descriptor);
+#endif
+}
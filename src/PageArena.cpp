@@ -0,0 +1,79 @@
+#include "PageArena.h"
+
+
+void* PageArena::Upstream::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	++allocations;
+	this->bytes += bytes;
+	return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+}
+
+void PageArena::Upstream::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment)
+{
+	std::pmr::new_delete_resource()->deallocate(pointer, bytes, alignment);
+}
+
+bool PageArena::Upstream::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
+
+PageArena::PageArena(std::size_t capacity)
+	: m_buffer(capacity ? new std::byte[capacity] : nullptr),
+	m_capacity(capacity),
+	m_allocations(0),
+	m_bytes(0)
+{
+	m_resource.emplace(m_buffer.get(), m_capacity, &m_upstream);
+}
+
+void PageArena::release()
+{
+	// Grown by whatever the heap had to add, the next page of the same size
+	// fits into the buffer alone. A page using under a quarter of the buffer
+	// shrinks it to twice its size, so one spike, like highlighting a whole
+	// file, isn't held for the rest of the run.
+	std::size_t needed = m_capacity + m_upstream.bytes;
+	if (m_upstream.bytes == 0 && m_bytes < m_capacity / 4) {
+		needed = m_bytes * 2;
+	}
+	m_resource.reset();
+	if (needed != m_capacity) {
+		m_buffer.reset(needed ? new std::byte[needed] : nullptr);
+		m_capacity = needed;
+	}
+
+	m_allocations = 0;
+	m_bytes = 0;
+	m_upstream.allocations = 0;
+	m_upstream.bytes = 0;
+	m_resource.emplace(m_buffer.get(), m_capacity, &m_upstream);
+}
+
+std::size_t PageArena::getAllocationCount() const
+{
+	return m_allocations;
+}
+
+std::size_t PageArena::getHeapAllocationCount() const
+{
+	return m_upstream.allocations;
+}
+
+void* PageArena::do_allocate(std::size_t bytes, std::size_t alignment)
+{
+	++m_allocations;
+	m_bytes += bytes;
+	return m_resource->allocate(bytes, alignment);
+}
+
+void PageArena::do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment)
+{
+	// Monotonic, memory only comes back on release
+	m_resource->deallocate(pointer, bytes, alignment);
+}
+
+bool PageArena::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+{
+	return this == &other;
+}
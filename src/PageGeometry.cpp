@@ -0,0 +1,84 @@
+#include "PageGeometry.h"
+
+
+PageGeometry::PageGeometry(std::pmr::memory_resource* resource)
+	: m_font(nullptr),
+	m_characterSize(0),
+	m_vertices(resource)
+{
+}
+
+void PageGeometry::clear()
+{
+	m_vertices.clear();
+}
+
+void PageGeometry::setFont(const sf::Font& font, sf::Uint32 characterSize)
+{
+	m_font = &font;
+	m_characterSize = characterSize;
+}
+
+void PageGeometry::reserve(std::size_t vertices)
+{
+	m_vertices.reserve(vertices);
+}
+
+void PageGeometry::addText(const SmartText& text)
+{
+	const std::pmr::vector<sf::Vertex>& vertices = text.getVertices();
+	if (vertices.empty()) {
+		return;
+	}
+
+	const sf::Transform& transform = text.getTransform();
+	for (const auto& vertex : vertices) {
+		m_vertices.emplace_back(transform.transformPoint(vertex.position), vertex.color, vertex.texCoords);
+	}
+}
+
+void PageGeometry::addVertices(const std::vector<sf::Vertex>& vertices, sf::Vector2f offset)
+{
+	for (const auto& vertex : vertices) {
+		m_vertices.emplace_back(vertex.position + offset, vertex.color, vertex.texCoords);
+	}
+}
+
+void PageGeometry::addRectangle(sf::FloatRect rect, sf::Color color)
+{
+	const sf::Vector2f texCoords(1.f, 1.f);
+	const float right = rect.left + rect.width;
+	const float bottom = rect.top + rect.height;
+
+	m_vertices.emplace_back(sf::Vector2f(rect.left, rect.top), color, texCoords);
+	m_vertices.emplace_back(sf::Vector2f(right, rect.top), color, texCoords);
+	m_vertices.emplace_back(sf::Vector2f(rect.left, bottom), color, texCoords);
+	m_vertices.emplace_back(sf::Vector2f(rect.left, bottom), color, texCoords);
+	m_vertices.emplace_back(sf::Vector2f(right, rect.top), color, texCoords);
+	m_vertices.emplace_back(sf::Vector2f(right, bottom), color, texCoords);
+}
+
+const sf::Font* PageGeometry::getFont() const
+{
+	return m_font;
+}
+
+sf::Uint32 PageGeometry::getCharacterSize() const
+{
+	return m_characterSize;
+}
+
+const std::pmr::vector<sf::Vertex>& PageGeometry::getVertices() const
+{
+	return m_vertices;
+}
+
+void PageGeometry::draw(sf::RenderTarget& target, sf::RenderStates states) const
+{
+	if (m_vertices.empty() || !m_font) {
+		return;
+	}
+
+	states.texture = &m_font->getTexture(m_characterSize);
+	target.draw(m_vertices.data(), m_vertices.size(), sf::PrimitiveType::Triangles, states);
+}
@@ -0,0 +1,151 @@
+#include "PageLayout.h"
+#include <cmath>
+
+
+PageLayout::PageLayout(const sf::Font& font, unsigned width, unsigned height, float borderHeight)
+	: m_font(&font),
+	m_width(width),
+	m_height(height),
+	m_borderHeight(borderHeight),
+	m_lineCount(0),
+	m_widestLine(),
+	m_widestSpans(nullptr),
+	m_widestWidth(0.f),
+	m_characterSize(1),
+	m_spacing(0.f),
+	m_linesPerPage(0),
+	m_pageCount(1)
+{
+
+}
+
+void PageLayout::addLine(std::string_view line, const std::vector<HighlightSpan>& spans)
+{
+	++m_lineCount;
+	const float width = measure(line, spans, *m_font, ReferenceSize);
+	if (!m_widestSpans || width > m_widestWidth) {
+		m_widestLine = line;
+		m_widestSpans = &spans;
+		m_widestWidth = width;
+	}
+}
+
+void PageLayout::solve(unsigned minimumSize)
+{
+	const unsigned widthLimit = getWidthLimit();
+	m_characterSize = getHeightLimit(m_lineCount, widthLimit);
+	m_linesPerPage = m_lineCount;
+	m_pageCount = 1;
+
+	if (m_characterSize < minimumSize && m_characterSize < widthLimit && m_lineCount > 1) {
+		// As many lines as fit at the minimum size, then the pages are
+		// balanced and each may use a larger size again
+		const unsigned size = std::min(minimumSize, widthLimit);
+		const std::size_t fitting = std::max<std::size_t>(1, static_cast<std::size_t>(m_height / getSlotHeight(size)));
+		m_pageCount = (m_lineCount + fitting - 1) / fitting;
+		m_linesPerPage = (m_lineCount + m_pageCount - 1) / m_pageCount;
+		m_characterSize = getHeightLimit(m_linesPerPage, widthLimit);
+	}
+	m_spacing = getSlotHeight(m_characterSize) - m_borderHeight;
+}
+
+unsigned PageLayout::getCharacterSize() const
+{
+	return m_characterSize;
+}
+
+float PageLayout::getSpacing() const
+{
+	return m_spacing;
+}
+
+std::size_t PageLayout::getLinesPerPage() const
+{
+	return m_linesPerPage;
+}
+
+std::size_t PageLayout::getPageCount() const
+{
+	return m_pageCount;
+}
+
+float PageLayout::measure(std::string_view line, const std::vector<HighlightSpan>& spans, const sf::Font& font, unsigned characterSize)
+{
+	const GlyphTable& regular = GlyphCache::get(font, characterSize, false);
+	const GlyphTable* bold = nullptr;
+
+	float x = 0.f;
+	sf::Uint32 previous = 0;
+	auto advance = [&x, &previous, &line](const GlyphTable& glyphs, std::size_t start, std::size_t end) {
+		for (std::size_t index = start; index != end; ++index) {
+			const sf::Uint32 current = static_cast<unsigned char>(line[index]);
+			switch (current)
+			{
+			case ' ':
+				x += glyphs.getSpaceAdvance();
+				previous = 0;
+				continue;
+			case '\t':
+				x += glyphs.getSpaceAdvance() * 4.f;
+				previous = 0;
+				continue;
+			}
+			if (previous) {
+				x += glyphs.getKerning(previous, current);
+			}
+			x += glyphs.getGlyph(current).advance;
+			previous = current;
+		}
+	};
+
+	// Spans cover the line without gaps, text past the last one is regular
+	std::size_t end = 0;
+	for (auto& span : spans) {
+		const GlyphTable* glyphs = &regular;
+		if (span.style & sf::Text::Style::Bold) {
+			bold = bold ? bold : &GlyphCache::get(font, characterSize, true);
+			glyphs = bold;
+		}
+		end = std::min(span.start + span.length, line.size());
+		advance(*glyphs, std::min(span.start, end), end);
+	}
+	advance(regular, end, line.size());
+	return x;
+}
+
+float PageLayout::getSlotHeight(unsigned characterSize) const
+{
+	return std::ceil(m_font->getLineSpacing(characterSize) * 1.2f) + m_borderHeight;
+}
+
+bool PageLayout::fitsWidth(unsigned characterSize) const
+{
+	return !m_widestSpans || measure(m_widestLine, *m_widestSpans, *m_font, characterSize) <= m_width;
+}
+
+bool PageLayout::fitsHeight(unsigned characterSize, std::size_t lines) const
+{
+	return getSlotHeight(characterSize) * lines <= m_height;
+}
+
+unsigned PageLayout::getWidthLimit() const
+{
+	const float estimate = m_widestWidth > 0.f ? m_width * ReferenceSize / m_widestWidth : static_cast<float>(MaximumSize);
+	return correct(estimate, MaximumSize, [this](unsigned size) {
+		return fitsWidth(size);
+	});
+}
+
+unsigned PageLayout::getHeightLimit(std::size_t lines, unsigned widthLimit) const
+{
+	if (lines == 0) {
+		return widthLimit;
+	}
+
+	// The slot is the line spacing scaled by 1.2 and rounded up, plus the border
+	const float slot = static_cast<float>(m_height) / lines - m_borderHeight;
+	const float estimate = slot / 1.2f * ReferenceSize / m_font->getLineSpacing(ReferenceSize);
+	return correct(estimate, widthLimit, [this, lines](unsigned size) {
+		return fitsHeight(size, lines);
+	});
+}
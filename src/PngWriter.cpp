@@ -0,0 +1,582 @@
+#include "PngWriter.h"
+#include "Deflate.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <unordered_map>
+
+namespace
+{
+	constexpr std::size_t MaximumColors = 256;
+	// Smallest amount of scanline bytes worth deflating on its own thread
+	constexpr std::size_t MinimumPiece = std::size_t{ 1 } << 16;
+
+	constexpr auto crcTable = [] {
+		std::array<std::uint32_t, 256> table{};
+		for (std::uint32_t index = 0; index != 256; ++index) {
+			std::uint32_t value = index;
+			for (int bit = 0; bit != 8; ++bit) {
+				value = value & 1 ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+			}
+			table[index] = value;
+		}
+		return table;
+	}();
+
+	enum Filter : std::uint8_t {
+		None,
+		Sub,
+		Up,
+		Average,
+		Paeth
+	};
+
+	// Fully transparent pixels look the same whatever their color, they are
+	// all counted as one palette entry
+	std::uint32_t readColor(const sf::Uint8* pixel)
+	{
+		if (pixel[3] == 0) {
+			return 0;
+		}
+		return pixel[0] | (pixel[1] << 8) | (pixel[2] << 16) | (static_cast<std::uint32_t>(pixel[3]) << 24);
+	}
+
+	// Colors in order of appearance and the palette index of every pixel,
+	// gives up once a color more than a palette holds shows up
+	bool findPalette(const sf::Uint8* pixels, std::size_t count, std::vector<std::uint32_t>& palette, std::vector<std::uint8_t>& indices)
+	{
+		// Open addressing, a slot holds its palette index plus one
+		constexpr std::size_t SlotCount = 1024;
+		std::array<std::uint32_t, SlotCount> colors;
+		std::array<std::uint16_t, SlotCount> slots{};
+
+		indices.resize(count);
+		std::uint32_t previous = 0;
+		std::uint8_t previousIndex = 0;
+		for (std::size_t pixel = 0; pixel != count; ++pixel) {
+			const std::uint32_t color = readColor(pixels + pixel * 4);
+			if (color == previous && pixel != 0) {
+				indices[pixel] = previousIndex;
+				continue;
+			}
+
+			std::size_t slot = (color * 2654435761u) >> 22;
+			while (slots[slot] && colors[slot] != color) {
+				slot = (slot + 1) & (SlotCount - 1);
+			}
+			if (!slots[slot]) {
+				if (palette.size() == MaximumColors) {
+					return false;
+				}
+				colors[slot] = color;
+				palette.push_back(color);
+				slots[slot] = static_cast<std::uint16_t>(palette.size());
+			}
+			previous = color;
+			previousIndex = static_cast<std::uint8_t>(slots[slot] - 1);
+			indices[pixel] = previousIndex;
+		}
+		return true;
+	}
+
+	std::uint8_t getChannel(std::uint32_t color, unsigned channel)
+	{
+		return static_cast<std::uint8_t>(color >> (channel * 8));
+	}
+
+	// Palette of at most 256 colors for a page with more. Fully transparent
+	// and opaque colors are kept exactly, the antialiased edges in between
+	// are split by median cut over the channel with the widest range and
+	// every edge color takes the closest entry.
+	void quantizePalette(const sf::Uint8* pixels, std::size_t count, std::vector<std::uint32_t>& palette, std::vector<std::uint8_t>& indices)
+	{
+		struct Entry
+		{
+			std::uint32_t color;
+			std::uint64_t count;
+		};
+
+		std::unordered_map<std::uint32_t, std::uint64_t> histogram;
+		for (std::size_t pixel = 0; pixel != count; ) {
+			const std::uint32_t color = readColor(pixels + pixel * 4);
+			std::size_t run = 1;
+			while (pixel + run != count && readColor(pixels + (pixel + run) * 4) == color) {
+				++run;
+			}
+			histogram[color] += run;
+			pixel += run;
+		}
+
+		std::vector<Entry> exact;
+		std::vector<Entry> edges;
+		for (auto& [color, uses] : histogram) {
+			const std::uint8_t alpha = getChannel(color, 3);
+			(alpha == 0 || alpha == 0xFF ? exact : edges).push_back({ color, uses });
+		}
+		if (exact.size() > MaximumColors / 2) {
+			edges.insert(edges.end(), exact.begin(), exact.end());
+			exact.clear();
+		}
+		// Sorted so the palette does not depend on the hash order
+		auto byColor = [](const Entry& left, const Entry& right) {
+			return left.color < right.color;
+		};
+		std::sort(exact.begin(), exact.end(), byColor);
+		std::sort(edges.begin(), edges.end(), byColor);
+
+		struct Box
+		{
+			std::size_t begin;
+			std::size_t end;
+			unsigned channel;
+			unsigned range;
+		};
+		auto makeBox = [&edges](std::size_t begin, std::size_t end) {
+			Box box{ begin, end, 0, 0 };
+			for (unsigned channel = 0; channel != 4; ++channel) {
+				std::uint8_t low = 0xFF;
+				std::uint8_t high = 0;
+				for (std::size_t index = begin; index != end; ++index) {
+					low = std::min(low, getChannel(edges[index].color, channel));
+					high = std::max(high, getChannel(edges[index].color, channel));
+				}
+				if (end != begin && static_cast<unsigned>(high - low) > box.range) {
+					box.channel = channel;
+					box.range = high - low;
+				}
+			}
+			return box;
+		};
+
+		std::vector<Box> boxes;
+		if (!edges.empty()) {
+			boxes.push_back(makeBox(0, edges.size()));
+		}
+		while (boxes.size() + exact.size() < MaximumColors) {
+			auto widest = std::max_element(boxes.begin(), boxes.end(), [](const Box& left, const Box& right) {
+				return left.range < right.range;
+			});
+			if (widest == boxes.end() || widest->range == 0) {
+				break;
+			}
+
+			// Split at the median of the uses, both halves keep a color
+			const Box box = *widest;
+			std::sort(edges.begin() + box.begin, edges.begin() + box.end, [&box](const Entry& left, const Entry& right) {
+				return getChannel(left.color, box.channel) < getChannel(right.color, box.channel);
+			});
+			std::uint64_t total = 0;
+			for (std::size_t index = box.begin; index != box.end; ++index) {
+				total += edges[index].count;
+			}
+			std::size_t middle = box.begin + 1;
+			for (std::uint64_t uses = edges[box.begin].count; middle + 1 < box.end && uses * 2 < total; ++middle) {
+				uses += edges[middle].count;
+			}
+			*widest = makeBox(box.begin, middle);
+			boxes.push_back(makeBox(middle, box.end));
+		}
+
+		for (auto& entry : exact) {
+			palette.push_back(entry.color);
+		}
+		for (auto& box : boxes) {
+			std::array<std::uint64_t, 4> sums{};
+			std::uint64_t total = 0;
+			for (std::size_t index = box.begin; index != box.end; ++index) {
+				for (unsigned channel = 0; channel != 4; ++channel) {
+					sums[channel] += getChannel(edges[index].color, channel) * edges[index].count;
+				}
+				total += edges[index].count;
+			}
+			std::uint32_t color = 0;
+			for (unsigned channel = 0; channel != 4; ++channel) {
+				color |= static_cast<std::uint32_t>((sums[channel] + total / 2) / total) << (channel * 8);
+			}
+			palette.push_back(color);
+		}
+
+		// Distinct colors are few, every one is matched once and pixels look
+		// their index up
+		std::unordered_map<std::uint32_t, std::uint8_t> closest;
+		for (auto& [color, uses] : histogram) {
+			std::size_t best = 0;
+			unsigned bestDistance = ~0u;
+			for (std::size_t index = 0; index != palette.size() && bestDistance != 0; ++index) {
+				unsigned distance = 0;
+				for (unsigned channel = 0; channel != 4; ++channel) {
+					const int difference = getChannel(color, channel) - getChannel(palette[index], channel);
+					distance += difference * difference;
+				}
+				if (distance < bestDistance) {
+					best = index;
+					bestDistance = distance;
+				}
+			}
+			closest.emplace(color, static_cast<std::uint8_t>(best));
+		}
+
+		indices.resize(count);
+		for (std::size_t pixel = 0; pixel != count; ) {
+			const std::uint32_t color = readColor(pixels + pixel * 4);
+			const std::uint8_t index = closest[color];
+			for (; pixel != count && readColor(pixels + pixel * 4) == color; ++pixel) {
+				indices[pixel] = index;
+			}
+		}
+	}
+
+	std::uint8_t paeth(std::uint8_t left, std::uint8_t up, std::uint8_t upLeft)
+	{
+		const int estimate = left + up - upLeft;
+		const int toLeft = std::abs(estimate - left);
+		const int toUp = std::abs(estimate - up);
+		const int toUpLeft = std::abs(estimate - upLeft);
+		if (toLeft <= toUp && toLeft <= toUpLeft) {
+			return left;
+		}
+		return toUp <= toUpLeft ? up : upLeft;
+	}
+
+	// Tries every filter on a row of RGBA pixels and keeps the one with the
+	// smallest sum of absolute differences, as libpng does
+	void filterRow(const std::uint8_t* row, const std::uint8_t* above, std::size_t size, std::uint8_t* output, std::vector<std::uint8_t>& scratch)
+	{
+		constexpr std::size_t Stride = 4;
+		scratch.resize(size * 5);
+
+		for (std::size_t index = 0; index != size; ++index) {
+			const std::uint8_t left = index >= Stride ? row[index - Stride] : 0;
+			const std::uint8_t up = above ? above[index] : 0;
+			const std::uint8_t upLeft = above && index >= Stride ? above[index - Stride] : 0;
+			scratch[index] = row[index];
+			scratch[size + index] = static_cast<std::uint8_t>(row[index] - left);
+			scratch[size * 2 + index] = static_cast<std::uint8_t>(row[index] - up);
+			scratch[size * 3 + index] = static_cast<std::uint8_t>(row[index] - ((left + up) >> 1));
+			scratch[size * 4 + index] = static_cast<std::uint8_t>(row[index] - paeth(left, up, upLeft));
+		}
+
+		std::uint8_t best = None;
+		std::uint64_t bestSum = ~std::uint64_t{ 0 };
+		for (std::uint8_t filter = None; filter <= Paeth; ++filter) {
+			std::uint64_t sum = 0;
+			for (std::size_t index = 0; index != size; ++index) {
+				sum += std::abs(static_cast<std::int8_t>(scratch[size * filter + index]));
+			}
+			if (sum < bestSum) {
+				best = filter;
+				bestSum = sum;
+			}
+		}
+
+		output[0] = best;
+		std::copy_n(scratch.begin() + size * best, size, output + 1);
+	}
+
+	void writeUint32(std::vector<std::uint8_t>& output, std::uint32_t value)
+	{
+		for (int shift = 24; shift >= 0; shift -= 8) {
+			output.push_back(static_cast<std::uint8_t>(value >> shift));
+		}
+	}
+
+	// Starts a chunk, its length and crc are filled in by endChunk
+	std::size_t beginChunk(std::vector<std::uint8_t>& output, const char* type)
+	{
+		const std::size_t start = output.size();
+		writeUint32(output, 0);
+		output.insert(output.end(), type, type + 4);
+		return start;
+	}
+
+	void endChunk(std::vector<std::uint8_t>& output, std::size_t start)
+	{
+		const std::uint32_t length = static_cast<std::uint32_t>(output.size() - start - 8);
+		for (int index = 0; index != 4; ++index) {
+			output[start + index] = static_cast<std::uint8_t>(length >> (24 - index * 8));
+		}
+		writeUint32(output, PngWriter::crc32(output.data() + start + 4, length + 4));
+	}
+
+	void writeHeader(std::vector<std::uint8_t>& output, unsigned width, unsigned height, unsigned bitDepth, bool indexed)
+	{
+		output.insert(output.end(), { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' });
+		const std::size_t chunk = beginChunk(output, "IHDR");
+		writeUint32(output, width);
+		writeUint32(output, height);
+		output.insert(output.end(), { static_cast<std::uint8_t>(bitDepth), static_cast<std::uint8_t>(indexed ? 3 : 6), 0, 0, 0 });
+		endChunk(output, chunk);
+	}
+
+	// zlib header with the level hint
+	void writeZlibHeader(std::vector<std::uint8_t>& output, int level)
+	{
+		const std::uint8_t flags = level <= 1 ? 0x01 : level <= 5 ? 0x5E : level == 6 ? 0x9C : 0xDA;
+		output.insert(output.end(), { 0x78, flags });
+	}
+
+	// Rows are split into pieces of whole rows, one per thread as long as
+	// every piece is worth deflating on its own
+	std::size_t getPieceCount(std::size_t size, std::size_t threads, unsigned rows)
+	{
+		return std::clamp<std::size_t>(size / MinimumPiece, 1, std::min<std::size_t>(threads, std::max(rows, 1u)));
+	}
+
+	void forEachPiece(WorkerPool* pool, std::size_t pieceCount, const std::function<void(std::size_t)>& task)
+	{
+		if (pieceCount == 1 || !pool) {
+			for (std::size_t piece = 0; piece != pieceCount; ++piece) {
+				task(piece);
+			}
+			return;
+		}
+		for (std::size_t piece = 0; piece != pieceCount; ++piece) {
+			pool->submit([&task, piece]() { task(piece); });
+		}
+		pool->wait();
+	}
+
+	// Deflates the scanlines [begin, end) piece by piece and appends them,
+	// every piece may refer back into the bytes before it
+	void compressPieces(WorkerPool* pool, const std::uint8_t* scanlines, std::size_t begin, std::size_t end, const std::function<std::size_t(std::size_t)>& getOffset, std::size_t pieceCount, int level, bool last, std::vector<std::uint8_t>& output, std::uint32_t& adler)
+	{
+		std::vector<std::vector<std::uint8_t>> deflated(pieceCount);
+		std::vector<std::uint32_t> adlers(pieceCount);
+		forEachPiece(pool, pieceCount, [&](std::size_t piece) {
+			const std::size_t first = begin + getOffset(piece);
+			const std::size_t second = piece + 1 == pieceCount ? end : begin + getOffset(piece + 1);
+			Deflate::compress(scanlines, first, second, level, last && piece + 1 == pieceCount, deflated[piece]);
+			adlers[piece] = Deflate::adler32(scanlines + first, second - first);
+		});
+
+		for (std::size_t piece = 0; piece != pieceCount; ++piece) {
+			output.insert(output.end(), deflated[piece].begin(), deflated[piece].end());
+			const std::size_t second = piece + 1 == pieceCount ? end - begin : getOffset(piece + 1);
+			adler = Deflate::combineAdler32(adler, adlers[piece], second - getOffset(piece));
+		}
+	}
+}
+
+PngWriter::PngWriter(int level, std::size_t threads, bool quantize)
+	: m_level(std::clamp(level, 0, Deflate::MaximumLevel)),
+	m_threads(std::max<std::size_t>(1, threads)),
+	m_quantize(quantize),
+	m_pool(m_threads > 1 ? std::make_unique<WorkerPool>(m_threads) : nullptr),
+	m_colorCount(0),
+	m_width(0),
+	m_height(0),
+	m_rowsWritten(0),
+	m_adler(1)
+{
+
+}
+
+PngWriter::~PngWriter() = default;
+
+bool PngWriter::saveToFile(const sf::Image& image, const std::string& filePath)
+{
+	const std::vector<std::uint8_t> png = encode(image.getPixelsPtr(), image.getSize().x, image.getSize().y);
+	std::ofstream output(filePath, std::ofstream::binary | std::ofstream::trunc);
+	output.write(reinterpret_cast<const char*>(png.data()), png.size());
+	return static_cast<bool>(output);
+}
+
+std::vector<std::uint8_t> PngWriter::encode(const sf::Uint8* pixels, unsigned width, unsigned height)
+{
+	const std::size_t pixelCount = static_cast<std::size_t>(width) * height;
+	std::vector<std::uint32_t> palette;
+	std::vector<std::uint8_t> indices;
+	bool indexed = findPalette(pixels, pixelCount, palette, indices);
+	if (!indexed && m_quantize) {
+		palette.clear();
+		quantizePalette(pixels, pixelCount, palette, indices);
+		indexed = true;
+	}
+	m_colorCount = indexed ? palette.size() : 0;
+
+	// Translucent entries go first, the transparency chunk ends at the last one
+	std::array<std::uint8_t, MaximumColors> remap{};
+	std::size_t translucent = 0;
+	if (indexed) {
+		std::vector<std::uint32_t> ordered;
+		for (int opaque = 0; opaque != 2; ++opaque) {
+			for (std::size_t index = 0; index != palette.size(); ++index) {
+				if ((palette[index] >> 24 == 0xFF) == (opaque == 1)) {
+					remap[index] = static_cast<std::uint8_t>(ordered.size());
+					ordered.push_back(palette[index]);
+				}
+			}
+			translucent = opaque == 0 ? ordered.size() : translucent;
+		}
+		palette = std::move(ordered);
+	}
+
+	const unsigned bitDepth = !indexed ? 8 : palette.size() <= 2 ? 1 : palette.size() <= 4 ? 2 : palette.size() <= 16 ? 4 : 8;
+	const std::size_t rowSize = indexed ? (static_cast<std::size_t>(width) * bitDepth + 7) / 8 : static_cast<std::size_t>(width) * 4;
+	std::vector<std::uint8_t> scanlines((rowSize + 1) * height);
+
+	// Pieces of whole rows, every piece is filtered and deflated on its own
+	const std::size_t pieceCount = getPieceCount(scanlines.size(), m_threads, height);
+	auto getRow = [height, pieceCount](std::size_t piece) {
+		return static_cast<std::size_t>(height) * piece / pieceCount;
+	};
+
+	forEachPiece(m_pool.get(), pieceCount, [&](std::size_t piece) {
+		std::vector<std::uint8_t> scratch;
+		for (std::size_t row = getRow(piece); row != getRow(piece + 1); ++row) {
+			std::uint8_t* output = scanlines.data() + row * (rowSize + 1);
+			if (!indexed) {
+				const std::uint8_t* current = pixels + row * rowSize;
+				filterRow(current, row ? current - rowSize : nullptr, rowSize, output, scratch);
+				continue;
+			}
+
+			// Palettes are left unfiltered, indices are packed from the top bit
+			output[0] = None;
+			std::fill_n(output + 1, rowSize, 0);
+			const std::uint8_t* rowIndices = indices.data() + row * width;
+			for (std::size_t column = 0; column != width; ++column) {
+				const std::size_t bit = column * bitDepth;
+				output[1 + bit / 8] |= static_cast<std::uint8_t>(remap[rowIndices[column]] << (8 - bitDepth - bit % 8));
+			}
+		}
+	});
+
+	std::vector<std::uint8_t> png;
+	writeHeader(png, width, height, bitDepth, indexed);
+	std::size_t chunk = 0;
+	if (indexed) {
+		chunk = beginChunk(png, "PLTE");
+		for (std::uint32_t color : palette) {
+			png.insert(png.end(), { static_cast<std::uint8_t>(color), static_cast<std::uint8_t>(color >> 8), static_cast<std::uint8_t>(color >> 16) });
+		}
+		endChunk(png, chunk);
+
+		if (translucent) {
+			chunk = beginChunk(png, "tRNS");
+			for (std::size_t index = 0; index != translucent; ++index) {
+				png.push_back(static_cast<std::uint8_t>(palette[index] >> 24));
+			}
+			endChunk(png, chunk);
+		}
+	}
+
+	// zlib stream: header, the pieces and the checksum
+	chunk = beginChunk(png, "IDAT");
+	writeZlibHeader(png, m_level);
+	std::uint32_t adler = 1;
+	compressPieces(m_pool.get(), scanlines.data(), 0, scanlines.size(), [&getRow, rowSize](std::size_t piece) {
+		return getRow(piece) * (rowSize + 1);
+	}, pieceCount, m_level, true, png, adler);
+	writeUint32(png, adler);
+	endChunk(png, chunk);
+
+	endChunk(png, beginChunk(png, "IEND"));
+	return png;
+}
+
+bool PngWriter::open(const std::string& filePath, unsigned width, unsigned height)
+{
+	m_file.open(filePath, std::ofstream::binary | std::ofstream::trunc);
+	m_filePath = filePath;
+	m_width = width;
+	m_height = height;
+	m_rowsWritten = 0;
+	m_adler = 1;
+	m_colorCount = 0;
+	m_window.clear();
+	m_previousRow.clear();
+
+	std::vector<std::uint8_t> header;
+	writeHeader(header, width, height, 8, false);
+	m_file.write(reinterpret_cast<const char*>(header.data()), header.size());
+	return static_cast<bool>(m_file);
+}
+
+bool PngWriter::writeRows(const sf::Uint8* pixels, unsigned rows)
+{
+	// The stream is already finished, more rows would follow the IEND chunk
+	if (!m_file.is_open() || m_rowsWritten == m_height) {
+		return false;
+	}
+	rows = std::min(rows, m_height - m_rowsWritten);
+	const std::size_t rowSize = static_cast<std::size_t>(m_width) * 4;
+	const bool last = m_rowsWritten + rows == m_height;
+
+	// The tail of the earlier scanlines stays in front of the band, deflate
+	// keeps referring back into it like in one whole image
+	const std::size_t begin = m_window.size();
+	std::vector<std::uint8_t> scanlines(std::move(m_window));
+	scanlines.resize(begin + (rowSize + 1) * rows);
+
+	const std::size_t pieceCount = getPieceCount(scanlines.size() - begin, m_threads, rows);
+	auto getRow = [rows, pieceCount](std::size_t piece) {
+		return static_cast<std::size_t>(rows) * piece / pieceCount;
+	};
+	forEachPiece(m_pool.get(), pieceCount, [&](std::size_t piece) {
+		std::vector<std::uint8_t> scratch;
+		for (std::size_t row = getRow(piece); row != getRow(piece + 1); ++row) {
+			const std::uint8_t* current = pixels + row * rowSize;
+			const std::uint8_t* above = row ? current - rowSize : m_previousRow.empty() ? nullptr : m_previousRow.data();
+			filterRow(current, above, rowSize, scanlines.data() + begin + row * (rowSize + 1), scratch);
+		}
+	});
+
+	std::vector<std::uint8_t> chunk;
+	const std::size_t start = beginChunk(chunk, "IDAT");
+	if (m_rowsWritten == 0) {
+		writeZlibHeader(chunk, m_level);
+	}
+	compressPieces(m_pool.get(), scanlines.data(), begin, scanlines.size(), [&getRow, rowSize](std::size_t piece) {
+		return getRow(piece) * (rowSize + 1);
+	}, pieceCount, m_level, last, chunk, m_adler);
+	if (last) {
+		writeUint32(chunk, m_adler);
+	}
+	endChunk(chunk, start);
+	if (last) {
+		endChunk(chunk, beginChunk(chunk, "IEND"));
+	}
+	m_file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+
+	m_rowsWritten += rows;
+	if (rows) {
+		m_previousRow.assign(pixels + (rows - 1) * rowSize, pixels + rows * rowSize);
+	}
+	const std::size_t kept = std::min(scanlines.size(), Deflate::WindowSize);
+	m_window.assign(scanlines.end() - kept, scanlines.end());
+	return static_cast<bool>(m_file);
+}
+
+bool PngWriter::close()
+{
+	bool complete = m_rowsWritten == m_height && m_file;
+	m_file.close();
+	complete = complete && m_file;
+	if (!complete && !m_filePath.empty()) {
+		std::error_code error;
+		std::filesystem::remove(m_filePath, error);
+	}
+	m_filePath.clear();
+	m_window = {};
+	m_previousRow = {};
+	return complete;
+}
+
+std::size_t PngWriter::getColorCount() const
+{
+	return m_colorCount;
+}
+
+std::uint32_t PngWriter::crc32(const std::uint8_t* data, std::size_t size, std::uint32_t crc)
+{
+	crc = ~crc;
+	for (std::size_t index = 0; index != size; ++index) {
+		crc = crcTable[(crc ^ data[index]) & 0xFF] ^ (crc >> 8);
+	}
+	return ~crc;
+}
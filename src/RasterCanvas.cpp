@@ -0,0 +1,305 @@
+#include "RasterCanvas.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <utility>
+#include "GlyphCache.h"
+
+namespace
+{
+	using AtlasKey = std::pair<const sf::Font*, sf::Uint32>;
+
+	// Texture read back for one (font, size) and the state it was read in,
+	// guarded by the same lock as the font
+	struct Atlas
+	{
+		std::shared_ptr<const sf::Image> image;
+		std::size_t glyphCount;
+		sf::Vector2u size;
+	};
+
+	std::map<AtlasKey, Atlas> atlases;
+
+	float edge(const sf::Vector2f& a, const sf::Vector2f& b, const sf::Vector2f& point)
+	{
+		return (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x);
+	}
+
+	// Top-left fill rule, pixels on an edge shared by the two triangles of a
+	// quad are only covered once.
+	bool isTopLeft(const sf::Vector2f& a, const sf::Vector2f& b)
+	{
+		return (a.y == b.y && b.x < a.x) || b.y > a.y;
+	}
+
+	bool covers(float weight, bool topLeft)
+	{
+		return weight > 0.f || (weight == 0.f && topLeft);
+	}
+
+	// Bilinear lookup, font textures are smooth so this matches the GL sampler
+	sf::Color sample(const sf::Image& atlas, float u, float v)
+	{
+		const sf::Vector2u size = atlas.getSize();
+		const sf::Uint8* pixels = atlas.getPixelsPtr();
+
+		const float x = std::clamp(u - 0.5f, 0.f, static_cast<float>(size.x - 1));
+		const float y = std::clamp(v - 0.5f, 0.f, static_cast<float>(size.y - 1));
+		const unsigned x0 = static_cast<unsigned>(x);
+		const unsigned y0 = static_cast<unsigned>(y);
+		const unsigned x1 = std::min(x0 + 1, size.x - 1);
+		const unsigned y1 = std::min(y0 + 1, size.y - 1);
+		const float fx = x - x0;
+		const float fy = y - y0;
+
+		const sf::Uint8* p00 = pixels + (static_cast<std::size_t>(y0) * size.x + x0) * 4;
+		const sf::Uint8* p10 = pixels + (static_cast<std::size_t>(y0) * size.x + x1) * 4;
+		const sf::Uint8* p01 = pixels + (static_cast<std::size_t>(y1) * size.x + x0) * 4;
+		const sf::Uint8* p11 = pixels + (static_cast<std::size_t>(y1) * size.x + x1) * 4;
+
+		sf::Uint8 channels[4];
+		for (std::size_t channel = 0; channel != 4; ++channel) {
+			const float top = p00[channel] + (p10[channel] - p00[channel]) * fx;
+			const float bottom = p01[channel] + (p11[channel] - p01[channel]) * fx;
+			channels[channel] = static_cast<sf::Uint8>(std::lround(top + (bottom - top) * fy));
+		}
+		return { channels[0], channels[1], channels[2], channels[3] };
+	}
+
+	// Quads are written as top-left, top-right, bottom-left, bottom-left,
+	// top-right, bottom-right. Unless italic or transformed they are axis
+	// aligned rectangles, which get area coverage on their edges.
+	bool isRectangle(const sf::Vertex* quad)
+	{
+		return quad[0].position.y == quad[1].position.y && quad[2].position.y == quad[5].position.y &&
+			quad[0].position.x == quad[2].position.x && quad[1].position.x == quad[5].position.x &&
+			quad[3].position == quad[2].position && quad[4].position == quad[1].position &&
+			quad[0].position.x < quad[1].position.x && quad[0].position.y < quad[2].position.y &&
+			quad[0].color == quad[5].color;
+	}
+
+	// Part of the pixel [start, start + 1) inside [low, high)
+	float overlap(int start, float low, float high)
+	{
+		return std::max(0.f, std::min(start + 1.f, high) - std::max(static_cast<float>(start), low));
+	}
+
+	sf::Uint8 modulate(sf::Uint8 left, sf::Uint8 right)
+	{
+		return static_cast<sf::Uint8>((left * right + 127) / 255);
+	}
+}
+
+RasterCanvas::RasterCanvas(unsigned width, unsigned height)
+	: m_width(width),
+	m_height(height),
+	m_pixels(static_cast<std::size_t>(width) * height * 4, 0)
+{
+}
+
+void RasterCanvas::clear(sf::Color color)
+{
+	for (std::size_t pixel = 0, size = m_pixels.size(); pixel != size; pixel += 4) {
+		m_pixels[pixel + 0] = color.r;
+		m_pixels[pixel + 1] = color.g;
+		m_pixels[pixel + 2] = color.b;
+		m_pixels[pixel + 3] = color.a;
+	}
+}
+
+void RasterCanvas::prepare(const PageGeometry& page)
+{
+	// Glyphs are loaded while the geometry is built, the atlas has to be
+	// read afterwards so that it contains every glyph of the page.
+	const sf::Font* font = page.getFont();
+	if (!font) {
+		return;
+	}
+
+	const std::size_t glyphCount = GlyphCache::getGlyphCount(*font, page.getCharacterSize());
+	const sf::Texture& texture = font->getTexture(page.getCharacterSize());
+	Atlas& atlas = atlases[{ font, page.getCharacterSize() }];
+	if (!atlas.image || atlas.glyphCount != glyphCount || atlas.size != texture.getSize()) {
+		// Canvases still drawing keep the image they were prepared with
+		atlas.image = std::make_shared<const sf::Image>(texture.copyToImage());
+		atlas.glyphCount = glyphCount;
+		atlas.size = texture.getSize();
+	}
+	m_atlas = atlas.image;
+}
+
+void RasterCanvas::draw(const PageGeometry& page, const sf::Transform& transform)
+{
+	const std::pmr::vector<sf::Vertex>& vertices = page.getVertices();
+	if (vertices.empty() || !m_atlas) {
+		return;
+	}
+
+	draw(vertices.data(), vertices.size(), transform, m_atlas.get());
+}
+
+void RasterCanvas::draw(const sf::Vertex* vertices, std::size_t count, const sf::Transform& transform, const sf::Image* atlas)
+{
+	for (std::size_t index = 0; index + 2 < count; ) {
+		sf::Vertex corners[6];
+		const std::size_t cornerCount = std::min<std::size_t>(6, count - index);
+		for (std::size_t corner = 0; corner != cornerCount; ++corner) {
+			corners[corner] = vertices[index + corner];
+			corners[corner].position = transform.transformPoint(corners[corner].position);
+		}
+		if (cornerCount == 6 && isRectangle(corners)) {
+			drawRectangle(corners[0], corners[5], atlas);
+			index += 6;
+			continue;
+		}
+		drawTriangle(corners[0], corners[1], corners[2], atlas);
+		index += 3;
+	}
+}
+
+void RasterCanvas::repeatRows(unsigned height, unsigned count)
+{
+	const std::size_t tile = static_cast<std::size_t>(m_width) * std::min(height, m_height) * 4;
+	for (std::size_t offset = tile; offset < m_pixels.size() && count > 1; offset += tile, --count) {
+		std::memcpy(m_pixels.data() + offset, m_pixels.data(), std::min(tile, m_pixels.size() - offset));
+	}
+}
+
+unsigned RasterCanvas::getWidth() const
+{
+	return m_width;
+}
+
+unsigned RasterCanvas::getHeight() const
+{
+	return m_height;
+}
+
+const sf::Uint8* RasterCanvas::getPixelsPtr() const
+{
+	return m_pixels.data();
+}
+
+sf::Image RasterCanvas::copyToImage() const
+{
+	sf::Image image;
+	image.create(m_width, m_height, m_pixels.data());
+	return image;
+}
+
+void RasterCanvas::drawTriangle(const sf::Vertex& a, const sf::Vertex& b, const sf::Vertex& c, const sf::Image* atlas)
+{
+	const float area = edge(a.position, b.position, c.position);
+	if (area == 0.f) {
+		return;
+	}
+	// Keep a consistent winding so the weights are positive inside
+	const sf::Vertex& first = a;
+	const sf::Vertex& second = area > 0.f ? b : c;
+	const sf::Vertex& third = area > 0.f ? c : b;
+	const float size = std::abs(area);
+
+	const float minX = std::min({ a.position.x, b.position.x, c.position.x });
+	const float maxX = std::max({ a.position.x, b.position.x, c.position.x });
+	const float minY = std::min({ a.position.y, b.position.y, c.position.y });
+	const float maxY = std::max({ a.position.y, b.position.y, c.position.y });
+	const int startX = std::max(0, static_cast<int>(std::floor(minX - 0.5f)));
+	const int startY = std::max(0, static_cast<int>(std::floor(minY - 0.5f)));
+	const int endX = std::min(static_cast<int>(m_width) - 1, static_cast<int>(std::ceil(maxX - 0.5f)));
+	const int endY = std::min(static_cast<int>(m_height) - 1, static_cast<int>(std::ceil(maxY - 0.5f)));
+
+	const bool topLeft0 = isTopLeft(second.position, third.position);
+	const bool topLeft1 = isTopLeft(third.position, first.position);
+	const bool topLeft2 = isTopLeft(first.position, second.position);
+
+	for (int y = startY; y <= endY; ++y) {
+		for (int x = startX; x <= endX; ++x) {
+			const sf::Vector2f center(x + 0.5f, y + 0.5f);
+			const float weight0 = edge(second.position, third.position, center);
+			const float weight1 = edge(third.position, first.position, center);
+			const float weight2 = edge(first.position, second.position, center);
+			if (!covers(weight0, topLeft0) || !covers(weight1, topLeft1) || !covers(weight2, topLeft2)) {
+				continue;
+			}
+
+			// Glyph quads use one color per triangle, only the texture varies
+			sf::Color color = first.color;
+			if (atlas) {
+				const float u = (first.texCoords.x * weight0 + second.texCoords.x * weight1 + third.texCoords.x * weight2) / size;
+				const float v = (first.texCoords.y * weight0 + second.texCoords.y * weight1 + third.texCoords.y * weight2) / size;
+				const sf::Color texel = sample(*atlas, u, v);
+				color.r = modulate(color.r, texel.r);
+				color.g = modulate(color.g, texel.g);
+				color.b = modulate(color.b, texel.b);
+				color.a = modulate(color.a, texel.a);
+			}
+			blend(static_cast<std::size_t>(y) * m_width + x, color);
+		}
+	}
+}
+
+void RasterCanvas::drawRectangle(const sf::Vertex& topLeft, const sf::Vertex& bottomRight, const sf::Image* atlas)
+{
+	const sf::Vector2f start = topLeft.position;
+	const sf::Vector2f end = bottomRight.position;
+	const int startX = std::max(0, static_cast<int>(std::floor(start.x)));
+	const int startY = std::max(0, static_cast<int>(std::floor(start.y)));
+	const int endX = std::min(static_cast<int>(m_width), static_cast<int>(std::ceil(end.x)));
+	const int endY = std::min(static_cast<int>(m_height), static_cast<int>(std::ceil(end.y)));
+	const sf::Vector2f scale((bottomRight.texCoords.x - topLeft.texCoords.x) / (end.x - start.x), (bottomRight.texCoords.y - topLeft.texCoords.y) / (end.y - start.y));
+
+	// Borders and lines map to a single texel, it is sampled once
+	sf::Color solid = topLeft.color;
+	if (atlas && topLeft.texCoords == bottomRight.texCoords) {
+		const sf::Color texel = sample(*atlas, topLeft.texCoords.x, topLeft.texCoords.y);
+		solid.r = modulate(solid.r, texel.r);
+		solid.g = modulate(solid.g, texel.g);
+		solid.b = modulate(solid.b, texel.b);
+		solid.a = modulate(solid.a, texel.a);
+		atlas = nullptr;
+	}
+
+	for (int y = startY; y < endY; ++y) {
+		const float coverageY = overlap(y, start.y, end.y);
+		// Edge pixels are sampled at the center of their covered part
+		const float centerY = std::clamp(y + 0.5f, start.y, end.y);
+		for (int x = startX; x < endX; ++x) {
+			const float coverage = coverageY * overlap(x, start.x, end.x);
+			if (coverage <= 0.f) {
+				continue;
+			}
+
+			sf::Color color = solid;
+			if (atlas) {
+				const float centerX = std::clamp(x + 0.5f, start.x, end.x);
+				const float u = topLeft.texCoords.x + (centerX - start.x) * scale.x;
+				const float v = topLeft.texCoords.y + (centerY - start.y) * scale.y;
+				const sf::Color texel = sample(*atlas, u, v);
+				color.r = modulate(color.r, texel.r);
+				color.g = modulate(color.g, texel.g);
+				color.b = modulate(color.b, texel.b);
+				color.a = modulate(color.a, texel.a);
+			}
+			// 4x multisampling covers part of an edge pixel, its area does here
+			color.a = static_cast<sf::Uint8>(std::lround(color.a * coverage));
+			blend(static_cast<std::size_t>(y) * m_width + x, color);
+		}
+	}
+}
+
+void RasterCanvas::blend(std::size_t pixel, sf::Color color)
+{
+	// sf::BlendAlpha: SrcAlpha/OneMinusSrcAlpha for color, One/OneMinusSrcAlpha for alpha
+	sf::Uint8* destination = &m_pixels[pixel * 4];
+	const float alpha = color.a / 255.f;
+	if (alpha <= 0.f) {
+		return;
+	}
+
+	const float inverse = 1.f - alpha;
+	destination[0] = static_cast<sf::Uint8>(std::lround(color.r * alpha + destination[0] * inverse));
+	destination[1] = static_cast<sf::Uint8>(std::lround(color.g * alpha + destination[1] * inverse));
+	destination[2] = static_cast<sf::Uint8>(std::lround(color.b * alpha + destination[2] * inverse));
+	destination[3] = static_cast<sf::Uint8>(std::lround(255.f * alpha + destination[3] * inverse));
+}
@@ -1,6 +1,7 @@
 #include "Scrambler.h"
-#include <fstream>
-#include "Utilities.h"
+#include <algorithm>
+#include <numeric>
+#include "LineSplitter.h"
 
 
 Scrambler::Scrambler(const std::string& filePath, int difficulty)
@@ -12,37 +13,37 @@ Scrambler::Scrambler(const std::string& filePath, int difficulty)
 
 void Scrambler::loadFromFile(const std::string& filePath)
 {
-	std::ifstream stream(filePath, std::ifstream::in);
-	loadFromStream(stream);
+	m_buffer.clear();
+	if (!m_file.open(filePath)) {
+		loadFromData({});
+		return;
+	}
+	loadFromData(m_file.getView());
 }
 
 void Scrambler::loadFromStream(std::istream& stream)
 {
-	std::string line;
-	std::size_t lineNumber = 0;
-	std::size_t markStart  = std::string::npos;
+	m_file.close();
+	m_buffer.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	loadFromData(m_buffer);
+}
 
+void Scrambler::loadFromData(std::string_view data)
+{
 	m_lines.clear();
-	while (std::getline(stream, line)) {
-		if (beginsWith(line, "~>")) {
-			markStart = lineNumber;
-			line = line.substr(2);
-		}
-		if (endsWith(line, "<~")) {
-			markLines(markStart, lineNumber + 1, false);
-			line = line.substr(0, line.size() - 2);
-			markStart = std::string::npos;
-		}
+	m_markings.clear();
 
-		if (std::find_if_not(line.begin(), line.end(), std::isspace) != line.end()) {
-			if (m_difficulty > 0) {
-				ltrim(line);
-			}
-			m_lines.push_back(line);
-			++lineNumber;
+	LineSplitter splitter(data, m_difficulty > 0);
+	LineSplitter::Line line;
+	while (splitter.next(line)) {
+		if (line.fixedEnd) {
+			markLines(line.fixedStart, line.fixedEnd, false);
+		}
+		if (line.kept) {
+			m_lines.push_back(line.text);
 		}
 	}
-	m_markings.resize(lineNumber, true);
+	m_markings.resize(splitter.getLineCount(), true);
 }
 
 void Scrambler::seed()
@@ -70,29 +71,71 @@ void Scrambler::markLines(std::size_t start, std::size_t end, bool value)
 	std::fill(iterator + start, iterator + end, value);
 }
 
-const std::vector<std::string>& Scrambler::getLines() const
+const std::vector<std::string_view>& Scrambler::getLines() const
 {
 	return m_lines;
 }
 
-std::vector<std::string> Scrambler::getScrambling() const
+std::vector<std::size_t> Scrambler::getPermutation() const
 {
-	std::vector<std::string> scrambling{ m_lines };
-	std::vector<std::string>::iterator begin{ scrambling.begin() };
+	std::vector<std::size_t> permutation(m_lines.size());
+	std::iota(permutation.begin(), permutation.end(), std::size_t{ 0 });
+	std::vector<std::size_t>::iterator begin{ permutation.begin() };
 	
-	const std::size_t size = scrambling.size();
+	const std::size_t size = permutation.size();
 	for (std::size_t idx = 0; idx != size; ++idx) {
 		if (!m_markings[idx]) {
-			std::vector<std::string>::iterator end = scrambling.begin() + idx;
+			std::vector<std::size_t>::iterator end = permutation.begin() + idx;
 			scramble(begin, end);
 			begin = std::next(end);
 		}
 	}
-	scramble(begin, scrambling.end());
-	return scrambling;
+	scramble(begin, permutation.end());
+	return permutation;
 }
 
-void Scrambler::scramble(std::vector<std::string>::iterator begin, std::vector<std::string>::iterator end) const
+Scrambling Scrambler::getScrambling() const
+{
+	return { m_lines, getPermutation() };
+}
+
+void Scrambler::scramble(std::vector<std::size_t>::iterator begin, std::vector<std::size_t>::iterator end) const
 {
 	std::shuffle(begin, end, m_engine);
 }
+
+Scrambling::Scrambling(const std::vector<std::string_view>& lines, std::vector<std::size_t> order)
+	: m_lines(&lines),
+	m_order(std::move(order))
+{
+}
+
+std::size_t Scrambling::size() const
+{
+	return m_order.size();
+}
+
+bool Scrambling::empty() const
+{
+	return m_order.empty();
+}
+
+const std::string_view& Scrambling::operator[](std::size_t index) const
+{
+	return (*m_lines)[m_order[index]];
+}
+
+const std::vector<std::size_t>& Scrambling::getOrder() const
+{
+	return m_order;
+}
+
+Scrambling::const_iterator Scrambling::begin() const
+{
+	return { m_lines, m_order.begin() };
+}
+
+Scrambling::const_iterator Scrambling::end() const
+{
+	return { m_lines, m_order.end() };
+}
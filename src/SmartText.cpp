@@ -1,6 +1,9 @@
 #include "SmartText.h"
+#include "GlyphCache.h"
+#include "CharClass.h"
 #include <SFML/Graphics/Texture.hpp>
 #include <SFML/Graphics/RenderTarget.hpp>
+#include <algorithm>
 #include <cmath>
 
 ////////////////////////////////////////////////////////////
@@ -11,7 +14,7 @@
 namespace
 {
 	// Add an underline or strikethrough line to the vertex array
-	void addLine(float xOffset, std::vector<sf::Vertex>& vertices, float lineLength, float lineTop, const sf::Color& color, float offset, float thickness, float outlineThickness = 0)
+	void addLine(float xOffset, std::pmr::vector<sf::Vertex>& vertices, float lineLength, float lineTop, const sf::Color& color, float offset, float thickness, float outlineThickness = 0)
 	{
 		const sf::Vector2f texCoords(1.f, 1.f);
 		float top = std::roundf(lineTop + offset - (thickness / 2) + 0.5f);
@@ -26,7 +29,7 @@ namespace
 	}
 
 	// Add a glyph quad to the vertex array
-	void addGlyphQuad(std::vector<sf::Vertex>& vertices, sf::Vector2f position, const sf::Color& color, const sf::Glyph& glyph, float italic, float outlineThickness = 0)
+	void addGlyphQuad(std::pmr::vector<sf::Vertex>& vertices, sf::Vector2f position, const sf::Color& color, const sf::Glyph& glyph, float italic, float outlineThickness = 0)
 	{
 		float left = glyph.bounds.left;
 		float top = glyph.bounds.top;
@@ -45,14 +48,18 @@ namespace
 		vertices.emplace_back(sf::Vector2f(position.x + right - italic * bottom - outlineThickness, position.y + bottom - outlineThickness), color, sf::Vector2f(u2, v2));
 	}
 }
-SmartText::SmartText(const sf::String& text, const sf::Font& font)
-	: m_font(&font),
-	m_vertices(sf::PrimitiveType::Triangles)
+SmartText::SmartText(const sf::String& text, const sf::Font& font, std::pmr::memory_resource* resource)
+	: m_staleChunk(static_cast<std::size_t>(-1)),
+	m_font(&font),
+	m_chunks(resource),
+	m_vertices(resource),
+	m_outlineVertices(resource)
 {
 	setString(text);
 }
 
 SmartText::SmartText()
+	: m_staleChunk(static_cast<std::size_t>(-1))
 {
 
 }
@@ -149,6 +156,60 @@ void SmartText::setProperties(std::size_t start, std::size_t length, const Chunk
 	replaceChunk(start, data);
 }
 
+void SmartText::applySpans(const std::pmr::vector<Span>& spans)
+{
+	if (m_chunks.empty() || spans.empty()) {
+		return;
+	}
+
+	// Spans are sorted and do not overlap, so the new chunk list is a single
+	// merge of the chunk and span boundaries instead of one splice per span.
+	std::pmr::vector<Chunk> chunks(m_chunks.get_allocator());
+	chunks.reserve(m_chunks.size() + spans.size());
+
+	auto emit = [&chunks](const Chunk& chunk, std::size_t index, std::size_t length) {
+		if (!chunks.empty() && chunks.back() == chunk) {
+			chunks.back().length += length;
+			return;
+		}
+		chunks.push_back(chunk);
+		chunks.back().index = index;
+		chunks.back().length = length;
+	};
+
+	auto span = spans.begin();
+	std::size_t position = 0;
+	for (const auto& chunk : m_chunks) {
+		const std::size_t chunkEnd = position + chunk.length;
+
+		while (position != chunkEnd) {
+			while (span != spans.end() && span->start + span->data.length <= position) {
+				++span;
+			}
+
+			if (span == spans.end() || span->start >= chunkEnd) {
+				emit(chunk, position, chunkEnd - position);
+				position = chunkEnd;
+			}
+			else if (span->start > position) {
+				emit(chunk, position, span->start - position);
+				position = span->start;
+			}
+			else {
+				const std::size_t end = std::min(chunkEnd, span->start + span->data.length);
+				Chunk styled = chunk;
+				applyChunkData(styled, span->data);
+				emit(styled, position, end - position);
+				position = end;
+			}
+		}
+	}
+
+	m_chunks = std::move(chunks);
+	m_staleChunk = static_cast<std::size_t>(-1);
+	m_needsUpdate = true;
+}
+
 void SmartText::setString(const sf::String& text)
 {
 	m_string = "";
@@ -207,21 +268,31 @@ const sf::String& SmartText::getString() const
 
 const  SmartText::Chunk& SmartText::getChunk(std::size_t index) const
 {
+	ensureChunkIndices();
 	return m_chunks[index];
 }
 
+const std::pmr::vector<sf::Vertex>& SmartText::getVertices() const
+{
+	ensureGeometryUpdate();
+	return m_vertices;
+}
+
 const std::size_t SmartText::getChunkIndex(std::size_t subIndex) const
 {
-	const std::size_t chunkSize = m_chunks.size();
-	std::size_t chunkIndex = 0;
+	ensureChunkIndices();
 
-	for (std::size_t chunk = 0; chunk != chunkSize; ++chunk) {
-		if (subIndex < chunkIndex + m_chunks[chunk].length) {
-			return chunk;
-		}
-		else {
-			chunkIndex += m_chunks[chunk].length;
-		}
+	// Last chunk starting at or before the character
+	auto chunk = std::upper_bound(m_chunks.cbegin(), m_chunks.cend(), subIndex, [](std::size_t index, const Chunk& chunk) {
+		return index < chunk.index;
+	});
+	if (chunk == m_chunks.cbegin()) {
+		return static_cast<std::size_t>(-1);
+	}
+	--chunk;
+
+	if (subIndex < chunk->index + chunk->length) {
+		return static_cast<std::size_t>(chunk - m_chunks.cbegin());
 	}
 	return static_cast<std::size_t>(-1);
 }
@@ -233,15 +304,14 @@ sf::Vector2f SmartText::findLocalCharacterPos(std::size_t subIndex) const
 	std::size_t offset = 0U;
 	sf::Uint32 previous = 0U;
 	for (const auto& chunk : m_chunks) {
-		const sf::Font* font = chunk.font;
-		const sf::Uint32 characterSize = chunk.characterSize;
 		const bool bold = (chunk.style & sf::Text::Style::Bold) != 0;
-		const float space = font->getGlyph(L' ', characterSize, bold).advance;
-		const float vSpace = font->getLineSpacing(characterSize);
+		const GlyphTable& glyphs = GlyphCache::get(*chunk.font, chunk.characterSize, bold);
+		const float space = glyphs.getSpaceAdvance();
+		const float vSpace = glyphs.getLineSpacing();
 
 		for (std::size_t index = 0U; index != chunk.length; ++index) {
 			const auto& current = m_string[offset + index];
-			position.x += font->getKerning(previous, current, characterSize);
+			position.x += glyphs.getKerning(previous, current);
 
 			switch (current)
 			{
@@ -255,7 +325,7 @@ sf::Vector2f SmartText::findLocalCharacterPos(std::size_t subIndex) const
 				position.y += vSpace;
 				break;
 			default:
-				position.x += font->getGlyph(current, characterSize, bold).advance;
+				position.x += glyphs.getGlyph(current).advance;
 				break;
 			}
 			previous = current;
@@ -341,28 +411,30 @@ void SmartText::draw(sf::RenderTarget& target, sf::RenderStates states) const
 
 void SmartText::eraseChunk(std::size_t subIndex, std::size_t length)
 {
-	if (m_chunks.empty()) {
-		return;
-	}
 	const std::size_t start = getChunkIndex(subIndex);
-	const std::size_t end = getChunkIndex(subIndex + length);
-	auto chunkIter = m_chunks.begin() + end;
-
-	if (start != end) {
-		m_chunks[start].length -= (m_chunks[start].index + m_chunks[start].length) - subIndex;
-		m_chunks[end].length -= m_chunks[end].length - ((m_chunks[end].index + m_chunks[start].length) - (subIndex + length));
-		m_chunks[end].index = subIndex;
-		chunkIter = m_chunks.erase(m_chunks.begin() + start + (m_chunks[start].length != 0), chunkIter);
-		if (chunkIter != m_chunks.end()) {
-			++chunkIter;
-		}
+	if (start == static_cast<std::size_t>(-1)) {
+		return;
 	}
 
-	const auto endChunk = m_chunks.end();
-	for (; chunkIter != endChunk; ++chunkIter) {
-		chunkIter->index -= length;
+	// Shorten every chunk the range touches, then drop the emptied ones
+	std::size_t chunk = start;
+	std::size_t offset = subIndex - m_chunks[start].index;
+	while (length != 0 && chunk != m_chunks.size()) {
+		const std::size_t removed = std::min(m_chunks[chunk].length - offset, length);
+		m_chunks[chunk].length -= removed;
+		length -= removed;
+		offset = 0;
+		++chunk;
+	}
+	m_chunks.erase(std::remove_if(m_chunks.begin() + start, m_chunks.begin() + chunk, [](const Chunk& chunk) {
+		return chunk.length == 0;
+	}), m_chunks.begin() + chunk);
+
+	// Offsets behind the erased range are recomputed on the next lookup
+	invalidateChunkIndices(start);
+	if (!m_chunks.empty()) {
+		updateChunks(std::min(start != 0 ? start - 1 : 0, m_chunks.size() - 1));
 	}
-	updateChunks(start);
 	m_needsUpdate = true;
 }
 
@@ -372,36 +444,70 @@ void SmartText::insertChunk(std::size_t subIndex, const Chunk& chunk)
 
 	if (m_chunks.empty()) {
 		m_chunks.emplace_back(chunk);
+		m_chunks.back().index = 0;
 		return;
 	}
 	const std::size_t start = getChunkIndex(subIndex);
+	if (start == static_cast<std::size_t>(-1)) {
+		// Appending behind the last character
+		if (chunk == m_chunks.back()) {
+			m_chunks.back().length += chunk.length;
+		}
+		else {
+			m_chunks.emplace_back(chunk);
+			invalidateChunkIndices(m_chunks.size() - 1);
+		}
+		return;
+	}
+
 	auto chunkIter = m_chunks.begin() + start;
-	if (chunk == m_chunks[start]) {
-		m_chunks[start].length += chunk.length;
-		++chunkIter;
+	if (chunk == *chunkIter) {
+		chunkIter->length += chunk.length;
 	}
 	else {
 		const std::size_t splicedSize = (chunkIter->index + chunkIter->length) - subIndex;
 		Chunk splicedChunk = *chunkIter;
 		chunkIter->length -= splicedSize;
-		splicedChunk.index = chunkIter->index + chunk.length + chunkIter->length;
 		splicedChunk.length = splicedSize;
 
 		if (chunkIter->length == 0) {
 			*chunkIter = chunk;
-			++chunkIter;
-			m_chunks.insert(chunkIter++, splicedChunk);
+			m_chunks.insert(chunkIter + 1, splicedChunk);
 		}
 		else {
-			++chunkIter;
-			m_chunks.insert(chunkIter++, chunk);
-			m_chunks.insert(chunkIter++, splicedChunk);
+			chunkIter = m_chunks.insert(chunkIter + 1, chunk);
+			m_chunks.insert(chunkIter + 1, splicedChunk);
 		}
 	}
-	const auto endChunk = m_chunks.end();
-	for (; chunkIter != endChunk; ++chunkIter) {
-		chunkIter->index += chunk.length;
+
+	// Every chunk behind the insertion moved, their offsets are recomputed
+	// once on the next lookup instead of shifted here
+	invalidateChunkIndices(start);
+}
+
+void SmartText::invalidateChunkIndices(std::size_t chunk) const
+{
+	m_staleChunk = std::min(m_staleChunk, chunk);
+}
+
+void SmartText::ensureChunkIndices() const
+{
+	const std::size_t chunkSize = m_chunks.size();
+	if (m_staleChunk >= chunkSize) {
+		m_staleChunk = static_cast<std::size_t>(-1);
+		return;
 	}
+
+	std::size_t offset = 0;
+	if (m_staleChunk != 0) {
+		const Chunk& previous = m_chunks[m_staleChunk - 1];
+		offset = previous.index + previous.length;
+	}
+	for (std::size_t chunk = m_staleChunk; chunk != chunkSize; ++chunk) {
+		m_chunks[chunk].index = offset;
+		offset += m_chunks[chunk].length;
+	}
+	m_staleChunk = static_cast<std::size_t>(-1);
 }
 
 void SmartText::replaceChunk(std::size_t subIndex, const ChunkData& chunkData)
@@ -442,22 +548,25 @@ void SmartText::replaceChunk(std::size_t subIndex, const ChunkData& chunkData)
 		++offset;
 	}
 
-	const bool font = chunkData.font != nullptr;
 	for (std::size_t index = start + (splicedSize != startChunk.length), stop = (end == -1 ? m_chunks.size() : end + offset); index < stop; ++index) {
-		auto& chunk = m_chunks[index];
-		if (font) {
-			chunk.font = chunkData.font;
-		}
-		chunk.outlineThickness = chunkData.outlineThickness.value_or(chunk.outlineThickness);
-		chunk.characterSize = chunkData.characterSize.value_or(chunk.characterSize);
-		chunk.outlineColor = chunkData.outlineColor.value_or(chunk.outlineColor);
-		chunk.fillColor = chunkData.fillColor.value_or(chunk.fillColor);
-		chunk.style = chunkData.style.value_or(chunk.style);
+		applyChunkData(m_chunks[index], chunkData);
 	}
 	updateChunks(start);
 	m_needsUpdate = true;
 }
 
+void SmartText::applyChunkData(Chunk& chunk, const ChunkData& chunkData)
+{
+	if (chunkData.font != nullptr) {
+		chunk.font = chunkData.font;
+	}
+	chunk.outlineThickness = chunkData.outlineThickness.value_or(chunk.outlineThickness);
+	chunk.characterSize = chunkData.characterSize.value_or(chunk.characterSize);
+	chunk.outlineColor = chunkData.outlineColor.value_or(chunk.outlineColor);
+	chunk.fillColor = chunkData.fillColor.value_or(chunk.fillColor);
+	chunk.style = chunkData.style.value_or(chunk.style);
+}
+
 void SmartText::updateChunks(std::size_t start)
 {
 	auto last = m_chunks.end();
@@ -599,6 +708,24 @@ void SmartText::ensureGeometryUpdate() const
 		return left.characterSize < right.characterSize;
 		})->characterSize);
 
+	// At most one fill quad per character, outline quads only for outlined
+	// chunks and two lines per text line for underlined or struck chunks
+	std::size_t fillQuads = 0U;
+	std::size_t outlineQuads = 0U;
+	std::size_t start = 0U;
+	for (const auto& chunk : m_chunks) {
+		std::size_t quads = chunk.font ? chunk.length : 0U;
+		if (chunk.font && (chunk.style & (sf::Text::Style::Underlined | sf::Text::Style::StrikeThrough))) {
+			auto begin = m_string.begin() + start;
+			quads += 2U * (static_cast<std::size_t>(std::count(begin, begin + chunk.length, L'\n')) + 1U);
+		}
+		fillQuads += quads;
+		outlineQuads += chunk.outlineThickness != 0 ? quads : 0U;
+		start += chunk.length;
+	}
+	m_vertices.reserve(fillQuads * 6U);
+	m_outlineVertices.reserve(outlineQuads * 6U);
+
 	std::size_t offset = 0U;
 	sf::Uint32 verticeOffset = 0U;
 	sf::Uint32 prevChar = 0U;
@@ -613,18 +740,19 @@ void SmartText::ensureGeometryUpdate() const
 		const bool underlined = (chunk.style & sf::Text::Style::Underlined) != 0;
 		const bool strikeThrough = (chunk.style & sf::Text::Style::StrikeThrough) != 0;
 		const float italic = (chunk.style & sf::Text::Style::Italic) ? 0.208f : 0.f; // 12 degrees
-		const float underlineOffset = chunk.font->getUnderlinePosition(chunk.characterSize);
-		const float underlineThickness = chunk.font->getUnderlineThickness(chunk.characterSize);
+		const GlyphTable& glyphs = GlyphCache::get(*chunk.font, chunk.characterSize, bold, chunk.outlineThickness);
+		const float underlineOffset = glyphs.getUnderlinePosition();
+		const float underlineThickness = glyphs.getUnderlineThickness();
 
 		// Compute the location of the strike through dynamically
 		// We use the center point of the lowercase 'x' glyph as the reference
 		// We reuse the underline thickness as the thickness of the strike through as well
-		sf::FloatRect xBounds = chunk.font->getGlyph(L'x', chunk.characterSize, bold).bounds;
+		sf::FloatRect xBounds = glyphs.getXBounds();
 		float strikeThroughOffset = xBounds.top + xBounds.height / 2.f;
 
 		// Precompute the variables needed by the algorithm
-		float hspace = static_cast<float>(chunk.font->getGlyph(L' ', chunk.characterSize, bold).advance);
-		float vspace = static_cast<float>(chunk.font->getLineSpacing(chunk.characterSize));
+		float hspace = glyphs.getSpaceAdvance();
+		float vspace = glyphs.getLineSpacing();
 
 		// Create one quad for each character
 		minX = std::min(minX, static_cast<float>(chunk.characterSize));
@@ -634,7 +762,7 @@ void SmartText::ensureGeometryUpdate() const
 			sf::Uint32 curChar = m_string[offset + i];
 
 			// Apply the kerning offset
-			x += chunk.font->getKerning(prevChar, curChar, chunk.characterSize);
+			x += glyphs.getKerning(prevChar, curChar);
 			prevChar = curChar;
 
 			// If we're using the underlined style and there's a new line, draw a line
@@ -673,11 +801,12 @@ void SmartText::ensureGeometryUpdate() const
 				minX = std::min(minX, x);
 				minY = std::min(minY, y);
 
-				switch (curChar)
-				{
-				case ' ':  x += hspace;        break;
-				case '\t': x += hspace * 4;    break;
-				}
+				// The whole run of blanks only moves the pen, kerning between
+				// two blanks is left out
+				const BlankRun run = CharClass::blankRun(m_string.getData() + offset + i, chunk.length - i);
+				x += hspace * static_cast<float>(run.length - run.tabs) + hspace * 4 * static_cast<float>(run.tabs);
+				i += run.length - 1;
+				prevChar = m_string[offset + i];
 
 				// Update the current bounds (max coordinates)
 				maxX = std::max(maxX, x);
@@ -687,7 +816,7 @@ void SmartText::ensureGeometryUpdate() const
 				continue;
 			}
 
-			const sf::Glyph& glyph = chunk.font->getGlyph(curChar, chunk.characterSize, bold, chunk.outlineThickness);
+			const sf::Glyph& glyph = glyphs.getGlyph(curChar);
 			const float left = glyph.bounds.left;
 			const float top = glyph.bounds.top;
 			const float right = glyph.bounds.left + glyph.bounds.width;
@@ -704,21 +833,18 @@ void SmartText::ensureGeometryUpdate() const
 				maxX = std::max(maxX, x + right - italic * top - chunk.outlineThickness);
 				minY = std::min(minY, y + top - chunk.outlineThickness);
 				maxY = std::max(maxY, y + bottom - chunk.outlineThickness);
-				addGlyphQuad(m_vertices, sf::Vector2f(x, y), chunk.fillColor, glyph, italic);
 			}
 			else {
 				// Update the current bounds with the non outlined glyph bounds
-				addGlyphQuad(m_vertices, sf::Vector2f(x, y), chunk.fillColor, glyph, italic);
 				minX = std::min(minX, x + left - italic * bottom);
 				maxX = std::max(maxX, x + right - italic * top);
 				minY = std::min(minY, y + top);
 				maxY = std::max(maxY, y + bottom);
 			}
 
-			// Extract the current glyph's description
-
-			// Add the glyph to the vertices
+			// Add the glyph to the vertices, once whether outlined or not
 			addGlyphQuad(m_vertices, sf::Vector2f(x, y), chunk.fillColor, glyph, italic);
+
 			// Advance to the next character
 			x += glyph.advance;
 		}
@@ -0,0 +1,90 @@
+#include "StreamScrambler.h"
+#include <algorithm>
+#include <fstream>
+#include "LineSplitter.h"
+
+StreamScrambler::StreamScrambler(int difficulty)
+	: m_difficulty(difficulty)
+{
+	seed();
+}
+
+bool StreamScrambler::loadFromFile(const std::string& filePath)
+{
+	m_lines.clear();
+	m_markings.clear();
+	if (!m_file.open(filePath)) {
+		return false;
+	}
+
+	const char* data = m_file.getData();
+	LineSplitter splitter({ data, m_file.getSize() }, m_difficulty > 0);
+	LineSplitter::Line line;
+	while (splitter.next(line)) {
+		if (line.fixedEnd) {
+			markLines(line.fixedStart, line.fixedEnd, false);
+		}
+		if (line.kept) {
+			m_lines.push_back({ static_cast<std::uint64_t>(line.text.data() - data), line.text.size() });
+		}
+	}
+	m_markings.resize(splitter.getLineCount(), true);
+	return true;
+}
+
+void StreamScrambler::seed()
+{
+	seed(std::random_device()());
+}
+
+void StreamScrambler::seed(unsigned seed)
+{
+	m_engine.seed(seed);
+}
+
+std::size_t StreamScrambler::getLineCount() const
+{
+	return m_lines.size();
+}
+
+void StreamScrambler::scramble()
+{
+	auto begin = m_lines.begin();
+
+	const std::size_t size = m_lines.size();
+	for (std::size_t idx = 0; idx != size; ++idx) {
+		if (!m_markings[idx]) {
+			auto end = m_lines.begin() + idx;
+			std::shuffle(begin, end, m_engine);
+			begin = std::next(end);
+		}
+	}
+	std::shuffle(begin, m_lines.end(), m_engine);
+}
+
+bool StreamScrambler::saveScrambling(const std::string& filePath) const
+{
+	std::ofstream output(filePath, std::ofstream::trunc | std::ofstream::out | std::ofstream::binary);
+	if (!output) {
+		return false;
+	}
+
+	const char* data = m_file.getData();
+	for (const auto& line : m_lines) {
+		output.write(data + line.offset, line.length);
+		output.put('\n');
+	}
+
+	output.flush();
+	return static_cast<bool>(output);
+}
+
+void StreamScrambler::markLines(std::size_t start, std::size_t end, bool value)
+{
+	if (end > m_markings.size()) {
+		m_markings.resize(end, true);
+	}
+
+	auto iterator = m_markings.begin();
+	std::fill(iterator + start, iterator + end, value);
+}
@@ -0,0 +1,309 @@
+#include "SvgWriter.h"
+#include "GlyphCache.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <system_error>
+
+namespace
+{
+	// Two decimals are far below a printer dot at any -ppi
+	void appendNumber(std::string& output, float value)
+	{
+		char buffer[32];
+		int length = std::snprintf(buffer, sizeof(buffer), "%.2f", value);
+		while (length > 1 && buffer[length - 1] == '0') {
+			--length;
+		}
+		if (buffer[length - 1] == '.') {
+			--length;
+		}
+		output.append(buffer, length);
+	}
+
+	void appendColor(std::string& output, sf::Color color, const char* attribute)
+	{
+		char buffer[8];
+		std::snprintf(buffer, sizeof(buffer), "#%02x%02x%02x", color.r, color.g, color.b);
+		output += ' ';
+		output += attribute;
+		output += "=\"";
+		output += buffer;
+		output += '"';
+		if (color.a != 255) {
+			output += ' ';
+			output += attribute;
+			output += "-opacity=\"";
+			appendNumber(output, color.a / 255.f);
+			output += '"';
+		}
+	}
+
+	// Lines are bytes, anything outside ASCII is written as the code point
+	// of that byte like the raster path draws it
+	void appendCharacter(std::string& output, sf::Uint32 character)
+	{
+		switch (character)
+		{
+		case '&':
+			output += "&amp;";
+			return;
+		case '<':
+			output += "&lt;";
+			return;
+		case '>':
+			output += "&gt;";
+			return;
+		}
+		if (character >= 0x80) {
+			output += "&#" + std::to_string(character) + ';';
+		}
+		// Control characters are not allowed in XML
+		else if (character >= 0x20) {
+			output += static_cast<char>(character);
+		}
+	}
+
+	std::string encodeBase64(const std::string& data)
+	{
+		constexpr char Alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		std::string output;
+		output.reserve((data.size() + 2) / 3 * 4);
+		for (std::size_t index = 0; index < data.size(); index += 3) {
+			const std::size_t count = std::min<std::size_t>(3, data.size() - index);
+			std::uint32_t group = static_cast<unsigned char>(data[index]) << 16;
+			if (count > 1) {
+				group |= static_cast<unsigned char>(data[index + 1]) << 8;
+			}
+			if (count > 2) {
+				group |= static_cast<unsigned char>(data[index + 2]);
+			}
+			output += Alphabet[(group >> 18) & 0x3F];
+			output += Alphabet[(group >> 12) & 0x3F];
+			output += count > 1 ? Alphabet[(group >> 6) & 0x3F] : '=';
+			output += count > 2 ? Alphabet[group & 0x3F] : '=';
+		}
+		return output;
+	}
+
+	struct FontFormat
+	{
+		const char* type;
+		const char* format;
+	};
+
+	FontFormat getFontFormat(const std::string& fontPath)
+	{
+		std::string extension = std::filesystem::path(fontPath).extension().string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char ch) {
+			return static_cast<char>(std::tolower(ch));
+		});
+		if (extension == ".otf") {
+			return { "font/otf", "opentype" };
+		}
+		if (extension == ".woff") {
+			return { "font/woff", "woff" };
+		}
+		if (extension == ".woff2") {
+			return { "font/woff2", "woff2" };
+		}
+		return { "font/ttf", "truetype" };
+	}
+
+	// Path of the font relative to the page, characters outside of plain
+	// URLs are percent encoded which also keeps the attribute valid XML
+	std::string getFontUrl(const std::string& fontPath, const std::string& filePath)
+	{
+		std::error_code error;
+		const std::filesystem::path font = std::filesystem::absolute(fontPath, error);
+		const std::filesystem::path page = std::filesystem::absolute(filePath, error).parent_path();
+		std::filesystem::path path = std::filesystem::relative(font, page, error);
+		if (error || path.empty()) {
+			path = font;
+		}
+
+		std::string url;
+		for (char ch : path.generic_string()) {
+			if (std::isalnum(static_cast<unsigned char>(ch)) || ch == '/' || ch == '.' || ch == '-' || ch == '_' || ch == '~') {
+				url += ch;
+			}
+			else {
+				char buffer[4];
+				std::snprintf(buffer, sizeof(buffer), "%%%02X", static_cast<unsigned char>(ch));
+				url += buffer;
+			}
+		}
+		return url;
+	}
+}
+
+SvgWriter::SvgWriter(unsigned width, unsigned height, float ppi)
+	: m_width(width),
+	m_height(height),
+	m_ppi(ppi),
+	m_tileHeight(0.f),
+	m_tileCount(1),
+	m_runCount(0)
+{
+}
+
+void SvgWriter::addLine(std::string_view line, const std::vector<HighlightSpan>& spans, const sf::Font& font, unsigned characterSize, sf::Vector2f baseline)
+{
+	// Same pen walk as PageLayout::measure, blanks end a run and the next
+	// word starts a new one at the advanced pen
+	const GlyphTable& regular = GlyphCache::get(font, characterSize, false);
+	const GlyphTable* bold = nullptr;
+
+	m_body += "<text y=\"";
+	appendNumber(m_body, baseline.y);
+	m_body += "\" font-size=\"" + std::to_string(characterSize) + "\">";
+
+	float x = baseline.x;
+	sf::Uint32 previous = 0;
+	auto write = [this, &x, &previous, &line](const GlyphTable& glyphs, sf::Color color, sf::Uint32 style, std::size_t start, std::size_t end) {
+		bool open = false;
+		for (std::size_t index = start; index != end; ++index) {
+			const sf::Uint32 current = static_cast<unsigned char>(line[index]);
+			if (current == ' ' || current == '\t') {
+				x += glyphs.getSpaceAdvance() * (current == '\t' ? 4.f : 1.f);
+				previous = 0;
+				if (open) {
+					m_body += "</tspan>";
+					open = false;
+				}
+				continue;
+			}
+			if (previous) {
+				x += glyphs.getKerning(previous, current);
+			}
+
+			if (!open) {
+				m_body += "<tspan x=\"";
+				appendNumber(m_body, x);
+				m_body += '"';
+				appendColor(m_body, color, "fill");
+				if (style & sf::Text::Style::Bold) {
+					m_body += " font-weight=\"bold\"";
+				}
+				if (style & sf::Text::Style::Italic) {
+					m_body += " font-style=\"italic\"";
+				}
+				if (style & sf::Text::Style::Underlined) {
+					m_body += " text-decoration=\"underline\"";
+				}
+				else if (style & sf::Text::Style::StrikeThrough) {
+					m_body += " text-decoration=\"line-through\"";
+				}
+				m_body += '>';
+				open = true;
+				++m_runCount;
+			}
+			appendCharacter(m_body, current);
+			x += glyphs.getGlyph(current).advance;
+			previous = current;
+		}
+		if (open) {
+			m_body += "</tspan>";
+		}
+	};
+
+	// Spans cover the line without gaps, text past the last one is regular
+	std::size_t end = 0;
+	for (auto& span : spans) {
+		const GlyphTable* glyphs = &regular;
+		if (span.style & sf::Text::Style::Bold) {
+			bold = bold ? bold : &GlyphCache::get(font, characterSize, true);
+			glyphs = bold;
+		}
+		end = std::min(span.start + span.length, line.size());
+		write(*glyphs, span.color, span.style, std::min(span.start, end), end);
+	}
+	write(regular, sf::Color::Black, sf::Text::Style::Regular, end, line.size());
+	m_body += "</text>\n";
+}
+
+void SvgWriter::addRectangle(sf::FloatRect rect, sf::Color color)
+{
+	m_body += "<rect x=\"";
+	appendNumber(m_body, rect.left);
+	m_body += "\" y=\"";
+	appendNumber(m_body, rect.top);
+	m_body += "\" width=\"";
+	appendNumber(m_body, rect.width);
+	m_body += "\" height=\"";
+	appendNumber(m_body, rect.height);
+	m_body += '"';
+	appendColor(m_body, color, "fill");
+	m_body += "/>\n";
+}
+
+void SvgWriter::setTiles(float height, unsigned count)
+{
+	m_tileHeight = height;
+	m_tileCount = std::max(1u, count);
+}
+
+bool SvgWriter::saveToFile(const std::string& filePath, const std::string& fontPath, bool embedFont) const
+{
+	std::ofstream output(filePath, std::ofstream::binary | std::ofstream::trunc);
+	std::string header = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+		"<svg xmlns=\"http://www.w3.org/2000/svg\" xmlns:xlink=\"http://www.w3.org/1999/xlink\" width=\"";
+	appendNumber(header, m_width / m_ppi);
+	header += "in\" height=\"";
+	appendNumber(header, m_height / m_ppi);
+	header += "in\" viewBox=\"0 0 " + std::to_string(m_width) + ' ' + std::to_string(m_height) + "\">\n";
+	output << header;
+	output << "<style>\n";
+	if (embedFont) {
+		output << getFontFace(fontPath);
+	}
+	else {
+		output << "@font-face { font-family: \"Page\"; src: url(\"" << getFontUrl(fontPath, filePath) << "\") format(\"" << getFontFormat(fontPath).format << "\"); }\n";
+	}
+	output << "text { font-family: \"Page\", monospace; }\n</style>\n";
+
+	// Tiles are references to the first one, the page holds the text once
+	output << "<g id=\"tile\">\n" << m_body << "</g>\n";
+	for (unsigned tile = 1; tile < m_tileCount; ++tile) {
+		std::string use = "<use xlink:href=\"#tile\" y=\"";
+		appendNumber(use, m_tileHeight * tile);
+		output << use << "\"/>\n";
+	}
+	output << "</svg>\n";
+	return static_cast<bool>(output);
+}
+
+std::size_t SvgWriter::getRunCount() const
+{
+	return m_runCount;
+}
+
+const std::string& SvgWriter::getFontFace(const std::string& fontPath)
+{
+	static std::mutex mutex;
+	static std::map<std::string, std::string> faces;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto face = faces.find(fontPath);
+	if (face != faces.end()) {
+		return face->second;
+	}
+
+	std::string& rule = faces[fontPath];
+	std::ifstream input(fontPath, std::ifstream::binary);
+	const std::string data{ std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+	if (data.empty()) {
+		// Viewers fall back to the generic monospace family
+		return rule;
+	}
+
+	const FontFormat format = getFontFormat(fontPath);
+	rule = "@font-face { font-family: \"Page\"; src: url(data:" + std::string(format.type) + ";base64," + encodeBase64(data) + ") format(\"" + format.format + "\"); }\n";
+	return rule;
+}
@@ -0,0 +1,82 @@
+#include "WorkerPool.h"
+
+
+WorkerPool::WorkerPool(std::size_t workers, std::size_t capacity)
+	: m_capacity(capacity),
+	m_running(0),
+	m_stopping(false)
+{
+	if (workers == 0) {
+		workers = 1;
+	}
+	// Derived after clamping, a capacity of 0 would block every submit
+	if (m_capacity == 0) {
+		m_capacity = workers * 2;
+	}
+
+	m_workers.reserve(workers);
+	for (std::size_t index = 0; index != workers; ++index) {
+		m_workers.emplace_back(&WorkerPool::work, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_taskReady.notify_all();
+
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+void WorkerPool::submit(Task task)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_slotReady.wait(lock, [this]() { return m_tasks.size() < m_capacity; });
+	m_tasks.push(std::move(task));
+	lock.unlock();
+
+	m_taskReady.notify_one();
+}
+
+void WorkerPool::wait()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_idle.wait(lock, [this]() { return m_tasks.empty() && m_running == 0; });
+}
+
+std::size_t WorkerPool::getWorkerCount() const
+{
+	return m_workers.size();
+}
+
+void WorkerPool::work()
+{
+	while (true) {
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_taskReady.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+		if (m_tasks.empty()) {
+			return;
+		}
+
+		Task task = std::move(m_tasks.front());
+		m_tasks.pop();
+		++m_running;
+		lock.unlock();
+		m_slotReady.notify_one();
+
+		task();
+
+		lock.lock();
+		--m_running;
+		const bool idle = m_tasks.empty() && m_running == 0;
+		lock.unlock();
+		if (idle) {
+			m_idle.notify_all();
+		}
+	}
+}
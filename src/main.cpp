@@ -1,11 +1,25 @@
 #include <SFML/Graphics.hpp>
+#include <atomic>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <mutex>
+#include <thread>
 #include "Scrambler.h"
 #include "Highlighter.h"
 #include "Utilities.h"
 #include "CodeState.h"
+#include "WorkerPool.h"
+#include "RasterCanvas.h"
+#include "PageGeometry.h"
+#include "StreamScrambler.h"
+#include "LineCache.h"
+#include "GlyphCache.h"
+#include "PageArena.h"
+#include "PageLayout.h"
+#include "PngWriter.h"
+#include "Deflate.h"
+#include "SvgWriter.h"
 
 struct Settings
 {
@@ -13,8 +27,20 @@ struct Settings
 	std::string fontpath;
 	int difficulty;
 	int ppi;
+	int minimumSize;
 	int borders;
 	int fit;
+	int jobs;
+	int compression;
+	bool quantize;
+	int strip;
+	std::string backend;
+	bool embedFont;
+	bool stream;
+	std::optional<unsigned> seed;
+	int variants;
+	std::string profile;
+	std::filesystem::path keywords;
 
 	Settings(int argc, const char* argv[])
 	{
@@ -52,6 +78,13 @@ struct Settings
 		std::string argPPI = getCmdOption(argv, argv + argc, "-ppi");
 		ppi = parseType<int>(argPPI).value_or(300);
 
+		std::string argMinimumSize = getCmdOption(argv, argv + argc, "-minsize");
+		minimumSize = parseType<int>(argMinimumSize).value_or(8);
+		if (minimumSize < 1) {
+			sf::err() << "ERROR: minsize must be at least 1 point." << std::endl;
+			exitPrompt();
+		}
+
 		fontpath = getCmdOption(argv, argv + argc, "-font");
 
 		std::string argBorders = getCmdOption(argv, argv + argc, "-border");
@@ -66,19 +99,135 @@ struct Settings
 			sf::err() << "ERROR: fit must be greater than 1." << std::endl;
 			exitPrompt();
 		}
+		std::string argJobs = getCmdOption(argv, argv + argc, "-jobs");
+		jobs = parseType<int>(argJobs).value_or(1);
+		if (jobs < 1) {
+			sf::err() << "ERROR: jobs must be at least 1." << std::endl;
+			exitPrompt();
+		}
+		std::string argCompression = getCmdOption(argv, argv + argc, "-compression");
+		compression = parseType<int>(argCompression).value_or(6);
+		if (compression < 0 || compression > Deflate::MaximumLevel) {
+			sf::err() << "ERROR: compression must be between 0(stored) and 9(smallest)." << std::endl;
+			exitPrompt();
+		}
+		std::string argQuantize = getCmdOption(argv, argv + argc, "-quantize");
+		const int quantizeValue = parseType<int>(argQuantize).value_or(0);
+		if (quantizeValue != 0 && quantizeValue != 1) {
+			sf::err() << "ERROR: quantize must have a value of 0(exact colors), 1(reduce to 256 colors)." << std::endl;
+			exitPrompt();
+		}
+		quantize = quantizeValue == 1;
+		std::string argStrip = getCmdOption(argv, argv + argc, "-strip");
+		strip = parseType<int>(argStrip).value_or(0);
+		if (strip < 0) {
+			sf::err() << "ERROR: strip must be 0(whole page) or the height of a strip in pixels." << std::endl;
+			exitPrompt();
+		}
+
+		backend = getCmdOption(argv, argv + argc, "-backend");
+		if (backend.empty()) {
+			backend = "gl";
+		}
+		if (backend != "gl" && backend != "cpu" && backend != "svg") {
+			sf::err() << "ERROR: backend must be gl(OpenGL render texture), cpu(software compositor) or svg(vector image)." << std::endl;
+			exitPrompt();
+		}
+		std::string argEmbed = getCmdOption(argv, argv + argc, "-embed");
+		const int embedValue = parseType<int>(argEmbed).value_or(0);
+		if (embedValue != 0 && embedValue != 1) {
+			sf::err() << "ERROR: embed must have a value of 0(reference the font file), 1(embed the font file)." << std::endl;
+			exitPrompt();
+		}
+		embedFont = embedValue == 1;
+
+		std::string argStream = getCmdOption(argv, argv + argc, "-stream");
+		const int streamValue = parseType<int>(argStream).value_or(0);
+		if (streamValue != 0 && streamValue != 1) {
+			sf::err() << "ERROR: stream must have a value of 0(scramble and render), 1(only scramble, file stays mapped)." << std::endl;
+			exitPrompt();
+		}
+		stream = streamValue == 1;
+
+		std::string argSeed = getCmdOption(argv, argv + argc, "-seed");
+		if (!argSeed.empty()) {
+			seed = parseType<unsigned>(argSeed);
+			if (!seed) {
+				sf::err() << "ERROR: seed must be an unsigned integer." << std::endl;
+				exitPrompt();
+			}
+		}
+
+		std::string argVariants = getCmdOption(argv, argv + argc, "-variants");
+		variants = parseType<int>(argVariants).value_or(1);
+		if (variants < 1) {
+			sf::err() << "ERROR: variants must be at least 1." << std::endl;
+			exitPrompt();
+		}
+		// Streamed files are scrambled once without a manifest
+		if (stream && variants != 1) {
+			sf::err() << "ERROR: variants can't be used with stream 1, a streamed file is scrambled once." << std::endl;
+			exitPrompt();
+		}
+
+		profile = getCmdOption(argv, argv + argc, "-profile");
+		if (!profile.empty()) {
+			enableCodeProfile();
+		}
+
+		keywords = getCmdOption(argv, argv + argc, "-keywords");
+		if (!keywords.empty() && !std::filesystem::is_directory(keywords)) {
+			sf::err() << "ERROR: keywords must be a directory holding keywords.txt, stdtypes.txt or operators.txt." << std::endl;
+			exitPrompt();
+		}
 		popCodeState();
 	//	std::cout << "[COMPLETED]: Processing and loading arguments.\n" << std::endl;
 	}
 };
 
-using ScrambledCode = std::vector<std::string>;
+using ScrambledCode = Scrambling;
+
+// Highlighted source lines shared by every variant of a file
+struct HighlightedCode
+{
+	const sf::Font* font;
+	unsigned characterSize;
+	unsigned width;
+	unsigned height;
+	unsigned pageHeight; // Full paper, holds -fit tiles of the code height
+	float spacing;
+	float borderHeight;
+	std::size_t linesPerPage;
+	std::size_t pageCount;
+	std::vector<const LineCache::Spans*> lines;
+	LineCache* lineCache; // Holds the spans, and the geometry of every drawn line
+};
+
+namespace
+{
+	// OpenGL contexts and font textures are not shared between workers,
+	// only one file at a time touches them.
+	std::mutex renderMutex;
+}
+
+// Files that fail are reported, only the main thread exits once no worker
+// uses the font or the caches anymore
+bool processFile(const std::filesystem::path& file, const Settings& settings, const sf::Font& font, const Highlighter& keywords, LineCache& lineCache);
+bool streamScrambling(const std::filesystem::path& file, const Settings& settings);
 
-ScrambledCode createScrambling(const std::string& filepath, int difficulty);
 void saveScrambling(const ScrambledCode& code, const std::string& file);
+void saveManifest(const std::filesystem::path& file, unsigned seed, const std::vector<unsigned>& seeds);
 
-sf::Image renderScrambling(const ScrambledCode& code, Settings settings);
-void fitImage(sf::Image& image, Settings settings);
-void saveImage(const sf::Image& image, const std::string& file);
+HighlightedCode highlightCode(const std::vector<std::string_view>& lines, const sf::Font& font, const Highlighter& keywords, LineCache& lineCache, PageArena& arena);
+void layoutCode(HighlightedCode& code, const std::vector<std::string_view>& lines, const Settings& settings);
+sf::Image renderScrambling(const HighlightedCode& code, const ScrambledCode& scrambling, std::size_t pageIndex, Settings settings, PageArena& arena);
+PageGeometry buildPage(const HighlightedCode& code, const ScrambledCode& scrambling, std::size_t pageIndex, const Settings& settings, PageArena& arena);
+float getTextTop(const HighlightedCode& code);
+template<typename Page>
+void addBorders(Page& page, const HighlightedCode& code, std::size_t lineCount, const Settings& settings);
+bool saveImage(const sf::Image& image, const std::string& file, const Settings& settings);
+bool saveVector(const HighlightedCode& code, const ScrambledCode& scrambling, std::size_t pageIndex, const Settings& settings, const std::string& file);
+bool saveStrips(const HighlightedCode& code, const ScrambledCode& scrambling, std::size_t pageIndex, const Settings& settings, PageArena& arena, const std::string& file);
 
 
 
@@ -86,29 +235,156 @@ int main(int argc, const char* argv[])
 {
 	Settings settings(argc, argv);
 
-	
-	for (auto& file : settings.files) {
-		system("cls");
-		pushCodeState(file.filename().string());
-		ScrambledCode scrambling = createScrambling(file.string(), settings.difficulty);
-		saveScrambling(scrambling, file.filename().string());
-		sf::Image image = renderScrambling(scrambling, settings);
-		fitImage(image, settings);
-		saveImage(image, file.filename().replace_extension().string());
+	// Loaded once so glyphs and metrics are shared by every file, -stream
+	// only writes text and never touches it
+	sf::Font font;
+	if (!settings.stream) {
+		pushCodeState("Loading the font.");
+		if (!font.loadFromFile(settings.fontpath)) {
+			sf::err() << "ERROR: Couldn't load the requested font." << std::endl;
+			exitPrompt();
+		}
 		popCodeState();
 	}
+
+	// The built in tables need no loading, files of -keywords override them
+	Highlighter keywords;
+	if (!settings.keywords.empty()) {
+		pushCodeState("Loading the keywords.");
+		keywords.loadKeywords((settings.keywords / "keywords.txt").string(), KeywordGroup::Keyword);
+		keywords.loadKeywords((settings.keywords / "stdtypes.txt").string(), KeywordGroup::StdType);
+		keywords.loadKeywords((settings.keywords / "operators.txt").string(), KeywordGroup::Operator);
+		popCodeState();
+	}
+
+	LineCache lineCache;
+	if (settings.jobs == 1) {
+		for (auto& file : settings.files) {
+			system("cls");
+			if (!processFile(file, settings, font, keywords, lineCache)) {
+				exitPrompt();
+			}
+		}
+	}
+	else {
+		std::atomic<bool> failed{ false };
+		WorkerPool pool(settings.jobs);
+		for (auto& file : settings.files) {
+			pool.submit([&file, &settings, &font, &keywords, &lineCache, &failed]() {
+				if (!processFile(file, settings, font, keywords, lineCache)) {
+					failed = true;
+				}
+			});
+		}
+		pool.wait();
+		if (failed) {
+			exitPrompt();
+		}
+	}
+
+	if (!settings.profile.empty() && !saveCodeProfile(settings.profile)) {
+		sf::err() << "ERROR: Couldn't save the profile to it's destination." << std::endl;
+	}
 	std::cout << "Press enter to exit...";
 	std::cin.get();
 	return EXIT_SUCCESS;
 }
 
-ScrambledCode createScrambling(const std::string& filepath, int difficulty)
+bool processFile(const std::filesystem::path& file, const Settings& settings, const sf::Font& font, const Highlighter& keywords, LineCache& lineCache)
+{
+	if (settings.stream) {
+		return streamScrambling(file, settings);
+	}
+
+	pushCodeState(file.filename().string());
+	pushCodeState("Loading the code.");
+	Scrambler scrambler(file.string(), settings.difficulty);
+	countCodeState("lines", scrambler.getLines().size());
+	popCodeState();
+
+	// Temporaries of the highlighting and of every page, released once the
+	// page is saved
+	PageArena arena;
+
+	// Highlighting only depends on the source lines, every variant reuses it
+	HighlightedCode code = highlightCode(scrambler.getLines(), font, keywords, lineCache, arena);
+	layoutCode(code, scrambler.getLines(), settings);
+
+	const unsigned seed = settings.seed.value_or(std::random_device()());
+	const std::string stem = file.stem().string();
+	const std::string extension = file.extension().string();
+
+	std::vector<unsigned> seeds;
+	for (int variant = 0; variant != settings.variants; ++variant) {
+		seeds.push_back(deriveSeed(seed, variant));
+		const std::string suffix = settings.variants == 1 ? "" : "_v" + std::to_string(variant);
+
+		pushCodeState("Scrambling the code.");
+		scrambler.seed(seeds.back());
+		ScrambledCode scrambling = scrambler.getScrambling();
+		popCodeState();
+
+		saveScrambling(scrambling, stem + suffix + extension);
+		for (std::size_t page = 0; page != code.pageCount; ++page) {
+			const std::string pageSuffix = code.pageCount == 1 ? "" : "_p" + std::to_string(page);
+			bool saved = false;
+			if (settings.backend == "svg") {
+				saved = saveVector(code, scrambling, page, settings, stem + suffix + pageSuffix);
+			}
+			else if (settings.strip) {
+				saved = saveStrips(code, scrambling, page, settings, arena, stem + suffix + pageSuffix);
+			}
+			else {
+				sf::Image image = renderScrambling(code, scrambling, page, settings, arena);
+				saved = saveImage(image, stem + suffix + pageSuffix, settings);
+			}
+			arena.release();
+			if (!saved) {
+				popCodeState();
+				return false;
+			}
+		}
+	}
+	if (settings.seed || settings.variants > 1) {
+		saveManifest(file, seed, seeds);
+	}
+	popCodeState();
+	return true;
+}
+
+bool streamScrambling(const std::filesystem::path& file, const Settings& settings)
 {
+	pushCodeState(file.filename().string());
+	pushCodeState("Indexing the code.");
+	StreamScrambler scrambler(settings.difficulty);
+	if (!scrambler.loadFromFile(file.string())) {
+		sf::err() << "ERROR: Couldn't map the code to scramble." << std::endl;
+		popCodeState();
+		popCodeState();
+		return false;
+	}
+	if (settings.seed) {
+		scrambler.seed(*settings.seed);
+	}
+	countCodeState("lines", scrambler.getLineCount());
+	popCodeState();
+
 	pushCodeState("Scrambling the code.");
-	Scrambler scrambler(filepath, difficulty);
-	ScrambledCode scrambling = scrambler.getScrambling();
+	scrambler.scramble();
 	popCodeState();
-	return scrambling;
+
+	pushCodeState("Saving scramble to file.");
+	std::string directory = "..\\code_";
+	if (!scrambler.saveScrambling(directory + file.filename().string())) {
+		sf::err() << "ERROR: Couldn't save the scramble to it's destination." << std::endl;
+		popCodeState();
+		popCodeState();
+		return false;
+	}
+	countCodeState("bytes written", std::filesystem::file_size(directory + file.filename().string()));
+	popCodeState();
+	popCodeState();
+	return true;
 }
 
 void saveScrambling(const ScrambledCode& code, const std::string& file)
@@ -116,100 +392,340 @@ void saveScrambling(const ScrambledCode& code, const std::string& file)
 	pushCodeState("Saving scramble to file.");
 	std::string directory = "..\\code_";
 	outputContainer(directory + file, code);
+
+	std::size_t bytes = 0;
+	for (auto& line : code) {
+		bytes += line.size() + 1;
+	}
+	countCodeState("lines", code.size());
+	countCodeState("bytes written", bytes);
 	popCodeState();
 }
 
-sf::Image renderScrambling(const ScrambledCode& scrambling, Settings settings)
+void saveManifest(const std::filesystem::path& file, unsigned seed, const std::vector<unsigned>& seeds)
 {
-	pushCodeState("Highlighting and rendering the scrambling.");
-	sf::Font font;
-	if (!font.loadFromFile(settings.fontpath)) {
-		sf::err() << "ERROR: Couldn't load the requested font." << std::endl;
-		exitPrompt();
+	pushCodeState("Saving the variant manifest.");
+	std::string directory = "..\\manifest_";
+	std::ofstream output(directory + file.stem().string() + ".txt", std::ofstream::trunc | std::ofstream::out);
+	output << "file " << file.filename().string() << '\n';
+	output << "seed " << seed << '\n';
+	for (std::size_t variant = 0; variant != seeds.size(); ++variant) {
+		output << "variant " << variant << ' ' << seeds[variant] << '\n';
 	}
+	output.flush();
+	popCodeState();
+}
+
+HighlightedCode highlightCode(const std::vector<std::string_view>& lines, const sf::Font& font, const Highlighter& keywords, LineCache& lineCache, PageArena& arena)
+{
+	pushCodeState("Highlighting the code.");
+	HighlightedCode code;
+	code.font = &font;
+	code.lineCache = &lineCache;
+
+	// Only lines that were never seen before are lexed, repeated lines within
+	// the file are lexed once as well.
+	std::size_t hits = 0;
+	std::size_t misses = 0;
+	{
+		Highlighter highlighter(keywords, &arena);
+		LineCache::Spans spans;
+		code.lines.resize(lines.size(), nullptr);
+		for (std::size_t index = 0; index != lines.size(); ++index) {
+			code.lines[index] = lineCache.find(lines[index]);
+			if (code.lines[index]) {
+				++hits;
+				continue;
+			}
+			highlighter.highlight(lines[index], spans);
+			code.lines[index] = &lineCache.insert(lines[index], spans);
+			++misses;
+		}
+	}
+	countCodeState("line cache hits", hits);
+	countCodeState("line cache misses", misses);
+	countCodeState("allocations", arena.getAllocationCount());
+	countCodeState("heap allocations", arena.getHeapAllocationCount());
+	arena.release();
+	popCodeState();
+	return code;
+}
 
+void layoutCode(HighlightedCode& code, const std::vector<std::string_view>& lines, const Settings& settings)
+{
+	pushCodeState("Laying out the code.");
 	constexpr float PAPER_WIDTH  = 8.50;
 	constexpr float PAPER_HEIGHT = 11.0;
 
-	const unsigned width  = PAPER_WIDTH  * settings.ppi;
-	const unsigned height = PAPER_HEIGHT * settings.ppi / settings.fit;
-	const float borderHeight = std::round(settings.borders ? settings.ppi / 40.f : 0.f);
-	
-	unsigned characterSize = 4;
-	while (std::ceil((font.getLineSpacing(characterSize + 4) * 1.2f) + borderHeight) * scrambling.size() < height) {
-		characterSize += 4;
+	code.width  = PAPER_WIDTH  * settings.ppi;
+	code.pageHeight = PAPER_HEIGHT * settings.ppi;
+	code.height = code.pageHeight / settings.fit;
+	code.borderHeight = std::round(settings.borders ? settings.ppi / 40.f : 0.f);
+
+	// The font is shared by every worker, it is only queried while locked
+	std::lock_guard<std::mutex> lock(renderMutex);
+	PageLayout layout(*code.font, code.width, code.height, code.borderHeight);
+	for (std::size_t index = 0; index != lines.size(); ++index) {
+		layout.addLine(lines[index], *code.lines[index]);
+	}
+	// Points are 1/72 of an inch
+	layout.solve(static_cast<unsigned>(std::max(1.f, std::round(settings.minimumSize * settings.ppi / 72.f))));
+
+	code.characterSize = layout.getCharacterSize();
+	code.spacing = layout.getSpacing();
+	code.linesPerPage = layout.getLinesPerPage();
+	code.pageCount = layout.getPageCount();
+	countCodeState("character size", code.characterSize);
+	countCodeState("pages", code.pageCount);
+	popCodeState();
+}
+
+sf::Image renderScrambling(const HighlightedCode& code, const ScrambledCode& scrambling, std::size_t pageIndex, Settings settings, PageArena& arena)
+{
+	pushCodeState("Rendering the scrambling.");
+	// Declared first so the texture is released while still locked
+	std::unique_lock<std::mutex> lock(renderMutex);
+	PageGeometry page = buildPage(code, scrambling, pageIndex, settings, arena);
+	countCodeState("allocations", arena.getAllocationCount());
+	countCodeState("heap allocations", arena.getHeapAllocationCount());
+
+	// Every -fit tile goes straight into the page, instead of rendering one
+	// tile and copying it into a fresh page afterwards
+	countCodeState("tiles", settings.fit);
+	if (settings.backend == "cpu") {
+		RasterCanvas canvas(code.width, code.pageHeight);
+		canvas.prepare(page);
+		lock.unlock();
+
+		// A new canvas is already transparent, no need to clear the page
+		canvas.draw(page);
+		canvas.repeatRows(code.height, settings.fit);
+		sf::Image image = canvas.copyToImage();
+		popCodeState();
+		lock.lock();
+		return image;
 	}
-	const float spacing = std::ceil(font.getLineSpacing(characterSize) * 1.2f);
 
 	sf::ContextSettings context;
 	context.antialiasingLevel = 4;
 	sf::RenderTexture texture;
-	texture.create(width, height, context);
+	texture.create(code.width, code.pageHeight, context);
 	texture.clear(sf::Color::Transparent);
+	for (int tile = 0; tile != settings.fit; ++tile) {
+		sf::RenderStates states;
+		states.transform.translate(0.f, static_cast<float>(code.height * tile));
+		texture.draw(page, states);
+	}
+	texture.display();
+	popCodeState();
+	return texture.getTexture().copyToImage();
+}
+
+PageGeometry buildPage(const HighlightedCode& code, const ScrambledCode& scrambling, std::size_t pageIndex, const Settings& settings, PageArena& arena)
+{
+	// Every page holds the next linesPerPage lines of the scrambling
+	const std::size_t first = std::min(pageIndex * code.linesPerPage, scrambling.size());
+	const std::size_t last = std::min(first + code.linesPerPage, scrambling.size());
+
+	// A line is only laid out the first time it is drawn at this size, every
+	// repeat, on this page, another variant or another file, is a translated
+	// copy of its cached geometry.
+	std::pmr::vector<const LineCache::Vertices*> lines(&arena);
+	lines.reserve(last - first);
+	std::size_t vertexCount = 0;
+	std::size_t hits = 0;
+	std::size_t misses = 0;
+	for (std::size_t index = first; index != last; ++index) {
+		const std::string_view line = scrambling[index];
+		const LineCache::Vertices* vertices = code.lineCache->findGeometry(line, *code.font, code.characterSize);
+		if (vertices) {
+			++hits;
+		}
+		else {
+			std::pmr::vector<SmartText::Span> spans(&arena);
+			Highlighter::appendSpans(*code.lines[scrambling.getOrder()[index]], 0, spans);
 
-	Highlighter highlighter;
-	highlighter.setFont(font);
-	highlighter.setCharacterSize(characterSize);
+			SmartText text(sf::String::fromUtf8(line.begin(), line.end()), *code.font, &arena);
+			text.setCharacterSize(code.characterSize);
+			text.setFillColor(sf::Color::Black);
+			text.setStyle(sf::Text::Style::Regular);
+			text.applySpans(spans);
+			const std::pmr::vector<sf::Vertex>& built = text.getVertices();
+			vertices = &code.lineCache->insertGeometry(line, *code.font, code.characterSize, { built.begin(), built.end() });
+			++misses;
+		}
+		vertexCount += vertices->size();
+		lines.push_back(vertices);
+	}
+	countCodeState("geometry cache hits", hits);
+	countCodeState("geometry cache misses", misses);
+	countCodeState("glyph quads", vertexCount / 6);
+
+	const std::size_t strips = settings.borders == 1 ? 1 : settings.borders == 2 ? 48 : 0;
+	PageGeometry page(&arena);
+	page.setFont(*code.font, code.characterSize);
+	page.reserve(vertexCount + (last - first) * strips * 6);
+
+	// Lines are spaced by the slot height plus the border gap
+	float offset = getTextTop(code);
+	for (const LineCache::Vertices* vertices : lines) {
+		page.addVertices(*vertices, { 0.f, offset });
+		offset += code.spacing + code.borderHeight;
+	}
+	addBorders(page, code, last - first, settings);
+	countCodeState("vertices", page.getVertices().size());
+	return page;
+}
+
+float getTextTop(const HighlightedCode& code)
+{
+	// Lines are vertically centered on their slot by the middle of a lowercase
+	// 'x', the first baseline sits one character size below the top.
+	const sf::FloatRect xBounds = GlyphCache::get(*code.font, code.characterSize, false).getXBounds();
+	return std::round(code.spacing / 2.f - code.characterSize - (xBounds.top + xBounds.height / 2.f));
+}
+
+template<typename Page>
+void addBorders(Page& page, const HighlightedCode& code, std::size_t lineCount, const Settings& settings)
+{
+	const float width = static_cast<float>(code.width);
+	const float spacing = code.spacing;
+	const float borderHeight = code.borderHeight;
 
-	
-	
 	float offset = 0.f;
-	for (auto& line : scrambling) {
-		auto text = highlighter.buildText(line);
-		text.setPosition(0.f, offset + spacing / 2.f);
-		centerY(text);
-		texture.draw(text);
+	for (std::size_t line = 0; line != lineCount; ++line) {
 		if (settings.borders == 1) {
-			sf::RectangleShape border({ (float)width, borderHeight });
-			border.setFillColor(sf::Color::Black);
-			border.setPosition(0.f, offset + spacing);
-			texture.draw(border);
+			page.addRectangle({ 0.f, offset + spacing, width, borderHeight }, sf::Color::Black);
 		}
 		if (settings.borders == 2) {
 			const float stripWidth = width / 48.f;
 
 			for (std::size_t index = 0; index != 48; ++index) {
-				sf::RectangleShape border({ stripWidth * 0.667f, borderHeight });
-				border.setFillColor(sf::Color::Black);
-				border.setPosition(index*stripWidth, offset + spacing);
-				texture.draw(border);
+				page.addRectangle({ index*stripWidth, offset + spacing, stripWidth * 0.667f, borderHeight }, sf::Color::Black);
 			}
 		}
 		offset += spacing + borderHeight;
+	}
+}
 
+bool saveImage(const sf::Image& image, const std::string& file, const Settings& settings)
+{
+	pushCodeState("Saving scramble as an image.");
+	std::string directory = "..\\image_";
+	// Files saved at the same time share the cores for deflating
+	const std::size_t threads = std::max(1u, std::thread::hardware_concurrency() / settings.jobs);
+	PngWriter writer(settings.compression, threads, settings.quantize);
+	if (!writer.saveToFile(image, directory + file + ".png")) {
+		sf::err() << "ERROR: Couldn't save the image to it's destination." << std::endl;
+		popCodeState();
+		return false;
 	}
-	texture.display();
+	countCodeState("bytes written", std::filesystem::file_size(directory + file + ".png"));
+	countCodeState("colors", writer.getColorCount());
 	popCodeState();
-	return texture.getTexture().copyToImage();
+	return true;
 }
 
-void fitImage(sf::Image& image, Settings settings)
+bool saveVector(const HighlightedCode& code, const ScrambledCode& scrambling, std::size_t pageIndex, const Settings& settings, const std::string& file)
 {
+	pushCodeState("Saving scramble as a vector image.");
+	const std::size_t first = std::min(pageIndex * code.linesPerPage, scrambling.size());
+	const std::size_t last = std::min(first + code.linesPerPage, scrambling.size());
 
-	pushCodeState("Fitting image.");
-	constexpr float PAPER_WIDTH = 8.50;
-	constexpr float PAPER_HEIGHT = 11.0;
-
-	const unsigned width = PAPER_WIDTH * settings.ppi;
-	const unsigned height = PAPER_HEIGHT * settings.ppi;
+	// Same layout as buildPage, but the text is written as runs instead of
+	// being rasterized, so nothing grows with -ppi
+	SvgWriter writer(code.width, code.pageHeight, static_cast<float>(settings.ppi));
+	{
+		// Measuring may still load glyphs into the shared font
+		std::lock_guard<std::mutex> lock(renderMutex);
+		float baseline = getTextTop(code) + code.characterSize;
+		for (std::size_t index = first; index != last; ++index) {
+			writer.addLine(scrambling[index], *code.lines[scrambling.getOrder()[index]], *code.font, code.characterSize, { 0.f, baseline });
+			baseline += code.spacing + code.borderHeight;
+		}
+	}
+	addBorders(writer, code, last - first, settings);
+	writer.setTiles(static_cast<float>(code.height), settings.fit);
 
-	sf::Image fitted;
-	fitted.create(width, height);
-	for (std::size_t index = 0; index != settings.fit; ++index) {
-		fitted.copy(image, 0, image.getSize().y * index);
+	std::string directory = "..\\image_";
+	if (!writer.saveToFile(directory + file + ".svg", settings.fontpath, settings.embedFont)) {
+		sf::err() << "ERROR: Couldn't save the image to it's destination." << std::endl;
+		popCodeState();
+		return false;
 	}
-	image = fitted;
+	countCodeState("text runs", writer.getRunCount());
+	countCodeState("bytes written", std::filesystem::file_size(directory + file + ".svg"));
 	popCodeState();
+	return true;
 }
 
-void saveImage(const sf::Image& image, const std::string& file)
+bool saveStrips(const HighlightedCode& code, const ScrambledCode& scrambling, std::size_t pageIndex, const Settings& settings, PageArena& arena, const std::string& file)
 {
-	pushCodeState("Saving scramble as an image.");
+	pushCodeState("Rendering and saving the scrambling in strips.");
+	// Declared first so the texture is released while still locked
+	std::unique_lock<std::mutex> lock(renderMutex);
+	// Laid out once, every strip draws the same geometry shifted up, only
+	// one strip of pixels is held at a time
+	PageGeometry page = buildPage(code, scrambling, pageIndex, settings, arena);
+	const unsigned stripHeight = std::min(static_cast<unsigned>(settings.strip), code.pageHeight);
+
 	std::string directory = "..\\image_";
-	if (!image.saveToFile(directory + file + ".png")) {
+	const std::size_t threads = std::max(1u, std::thread::hardware_concurrency() / settings.jobs);
+	PngWriter writer(settings.compression, threads);
+	bool saved = writer.open(directory + file + ".png", code.width, code.pageHeight);
+
+	std::optional<RasterCanvas> canvas;
+	sf::RenderTexture texture;
+	if (settings.backend == "cpu") {
+		canvas.emplace(code.width, stripHeight);
+		canvas->prepare(page);
+		lock.unlock();
+	}
+	else {
+		sf::ContextSettings context;
+		context.antialiasingLevel = 4;
+		texture.create(code.width, stripHeight, context);
+		lock.unlock();
+	}
+
+	std::size_t strips = 0;
+	for (unsigned top = 0; top < code.pageHeight && saved; top += stripHeight, ++strips) {
+		const unsigned rows = std::min(stripHeight, code.pageHeight - top);
+		// Glyphs and borders may reach past their tile, every tile is drawn
+		// and whatever falls outside the strip is clipped
+		if (canvas) {
+			canvas->clear(sf::Color::Transparent);
+			for (int tile = 0; tile != settings.fit; ++tile) {
+				sf::Transform transform;
+				transform.translate(0.f, static_cast<float>(code.height * tile) - static_cast<float>(top));
+				canvas->draw(page, transform);
+			}
+			saved = writer.writeRows(canvas->getPixelsPtr(), rows);
+			continue;
+		}
+
+		// Only drawing needs the lock, the rows are deflated without it
+		lock.lock();
+		texture.clear(sf::Color::Transparent);
+		for (int tile = 0; tile != settings.fit; ++tile) {
+			sf::RenderStates states;
+			states.transform.translate(0.f, static_cast<float>(code.height * tile) - static_cast<float>(top));
+			texture.draw(page, states);
+		}
+		texture.display();
+		const sf::Image strip = texture.getTexture().copyToImage();
+		lock.unlock();
+		saved = writer.writeRows(strip.getPixelsPtr(), rows);
+	}
+	saved = writer.close() && saved;
+	if (saved) {
+		countCodeState("strips", strips);
+		countCodeState("bytes written", std::filesystem::file_size(directory + file + ".png"));
+	}
+	else {
 		sf::err() << "ERROR: Couldn't save the image to it's destination." << std::endl;
-		exitPrompt();
 	}
 	popCodeState();
+	lock.lock();
+	return saved;
 }
-
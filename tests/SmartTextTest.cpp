@@ -0,0 +1,91 @@
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include "SmartText.h"
+
+// Every visible glyph of a text is one fill quad of six vertices, outlines
+// live in their own array, and underlined or struck chunks add one quad per
+// text line they cover.
+//
+// SmartTextTest [font], the font defaults to media/consola.ttf of the
+// repository root.
+namespace
+{
+	std::size_t failures = 0;
+
+	std::size_t countVisible(const std::string& text)
+	{
+		return static_cast<std::size_t>(std::count_if(text.begin(), text.end(), [](char ch) {
+			return ch != ' ' && ch != '\t' && ch != '\n';
+		}));
+	}
+
+	void check(const char* name, const SmartText& text, std::size_t expectedQuads)
+	{
+		const std::size_t vertices = text.getVertices().size();
+		if (vertices != expectedQuads * 6) {
+			std::cerr << "FAILED: " << name << ", " << vertices << " vertices instead of " << expectedQuads * 6 << std::endl;
+			++failures;
+			return;
+		}
+		std::cout << "passed: " << name << std::endl;
+	}
+}
+
+int main(int argc, const char* argv[])
+{
+	sf::Font font;
+	if (!font.loadFromFile(argc > 1 ? argv[1] : "media/consola.ttf")) {
+		std::cerr << "FAILED: Couldn't load the font." << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	{
+		const std::string string = "int value = 0;";
+		SmartText text(string, font);
+		check("plain", text, countVisible(string));
+	}
+	{
+		// Runs of blanks only move the pen
+		const std::string string = "a \t  \t b\t\t";
+		SmartText text(string, font);
+		check("blank runs", text, countVisible(string));
+	}
+	{
+		const std::string string = "if (ready)\n\treturn;\n\n}";
+		SmartText text(string, font);
+		text.setFillColor(0, 2, sf::Color::Blue);
+		text.setStyle(4, 5, sf::Text::Style::Bold);
+		check("chunks over several lines", text, countVisible(string));
+	}
+	{
+		// Outline quads don't add to the fill vertices
+		const std::string string = "outlined  text";
+		SmartText text(string, font);
+		text.setProperties(0, SmartText::ChunkData(8).outline(sf::Color::Red, 2.f));
+		check("outlined", text, countVisible(string));
+	}
+	{
+		const std::string string = "under lined";
+		SmartText text(string, font);
+		text.setStyle(sf::Text::Style::Underlined);
+		check("underlined", text, countVisible(string) + 1);
+	}
+	{
+		// One underline per text line and a strike through the last chunk
+		const std::string string = "first\nsecond  line";
+		SmartText text(string, font);
+		text.setStyle(0, 12, sf::Text::Style::Underlined);
+		text.setStyle(12, 6, sf::Text::Style::StrikeThrough);
+		check("underlined and struck lines", text, countVisible(string) + 2 + 1);
+	}
+
+	if (failures) {
+		std::cerr << failures << " checks FAILED" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "PASSED" << std::endl;
+	return EXIT_SUCCESS;
+}